@@ -20,6 +20,7 @@ Central::Central() {
   isLeader = false;
   current_term = 0;
   sizeOfData = 50000; // Todo: change this
+  reception_term = -1;
   // Set up in SetUp()
   allNodes = vector<pair<bool,int>>();
   recv_sock = 0; 
@@ -43,9 +44,9 @@ void Central::SetUp(Ptr<Node> node, vector<Ipv4Address> peers){
     isLeader = true;
   } 
 
+  socket_tid = TypeId::LookupByName("ns3::UdpSocketFactory");
   if (!recv_sock){
-    TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
-    recv_sock = Socket::CreateSocket(node, tid);
+    recv_sock = Socket::CreateSocket(node, socket_tid);
   }
 
   InetSocketAddress local = InetSocketAddress(Ipv4Address::GetAny(), 81);
@@ -65,6 +66,10 @@ void Central::StartApplication(){
 
 void Central::StopApplication(){
   running = false;
+
+  for (auto &s : peer_socks)
+    s.second->Close();
+  peer_socks.clear();
 }
 
 // Either follower receiving entire data from leader, or leader receiving a response.
@@ -82,26 +87,23 @@ void Central::ReceivePacket(Ptr<Socket> socket){
       debug_suffix << " Received Packet : New packet of " << packet->GetSize() << "B from Node " << ip;
       debug(debug_suffix.str());
       
-      string parsedPacket;
-      char* packetInfo = new char[packet->GetSize()];
-      packet->CopyData(reinterpret_cast<uint8_t*>(packetInfo),
-                    packet->GetSize());
-      string parsed_packet = string(packetInfo, packet->GetSize());
-      delete[] packetInfo;
+      if ((int) packet->GetSize() < ApplicationPacket::HEADER_SIZE){
+        continue;
+      }
 
       try{
-        ApplicationPacket p(parsed_packet);
+        // Only the header is read, the payload stays in the packet
+        ApplicationPacket p(packet);
 
      	if (p.GetService() == ApplicationPacket::DATA){
-          // Follower received a message from leader. Need to send reply/ack.
+          // Follower received a chunk from leader. Need to send reply/ack.
           debug_suffix.str("");
-	  debug_suffix << "Follower received DATA of size " << p.GetSize()
+	  debug_suffix << "Follower received DATA chunk " << p.GetChunk() << "/"
+		  << p.GetChunksCount() << " of size " << p.GetSize()
 		  << " from " << GetIdFromIp(ip) << " Sending reply"<< endl;
 	  debug(debug_suffix.str());
 
-      	  int term = p.GetTerm();
-	  ApplicationPacket reply(term);
-	  SendPacket(reply, ip, false);
+	  ReceiveChunk(p, ip);
 
 	} else if (p.GetService() == ApplicationPacket::REPLY) {
           // If follower sending reply, need to take note
@@ -127,26 +129,36 @@ void Central::SendPacket(ApplicationPacket& packet, Ipv4Address ip, bool schedul
     return;
   }
 
+  SendPacket(packet.ToPacket(), ip);
+}
+
+void Central::SendPacket(Ptr<Packet> pkt, Ipv4Address ip){
+  if (running == false || ip == GetIpAddressFromId(node->GetId())){ // Don't send packet to self
+    return;
+  }
+
   debug_suffix.str("");
-  debug_suffix << GetIdFromIp(ip) << " Sending packet of size " << packet.GetSize()
+  debug_suffix << GetIdFromIp(ip) << " Sending packet of size " << pkt->GetSize()
   	<< " to " << GetIdFromIp(ip) << endl;
   debug(debug_suffix.str());
 
-  Ptr<Packet> pkt = Create<Packet>((const uint8_t*)(packet.Serialize().data()), packet.GetSize());
-
-  TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
-  Ptr<Socket> source = Socket::CreateSocket (node, tid);
-  InetSocketAddress remote = InetSocketAddress (ip, 81);
-  source->Connect(remote);
-
-  int res = source->Send(pkt);
-  source->Close();
+  int res = GetPeerSocket(ip)->Send(pkt);
 
   if (res > 0){
   } else {
   }
 } 
 
+Ptr<Socket> Central::GetPeerSocket(Ipv4Address ip){
+  Ptr<Socket> &source = peer_socks[ip.Get()];
+  if (!source){
+    source = Socket::CreateSocket(node, socket_tid);
+    InetSocketAddress remote = InetSocketAddress(ip, 81);
+    source->Connect(remote);
+  }
+  return source;
+}
+
 // Need to modify this to only send to nodes in the group.
 // Change to broadcast properly
 void Central::BroadcastPacket(ApplicationPacket& packet){
@@ -159,13 +171,15 @@ void Central::BroadcastPacket(ApplicationPacket& packet){
   if (!running) {
     return;
   }
+  // Built once, every follower gets a copy-on-write copy
+  Ptr<Packet> pkt = packet.ToPacket();
   for (auto& ip : peers){
     if (allNodes[GetIdFromIp(ip)].first == true){ // if node is in group
       debug_suffix.str("");
       debug_suffix << "Broadcasting to: " << GetIdFromIp(ip) << endl;
       debug(debug_suffix.str());
 
-      SendPacket(packet, ip, false);
+      SendPacket(pkt->Copy(), ip);
     }
   } 
 
@@ -194,12 +208,18 @@ void Central::DisseminateData(){
   	<< " at term " << current_term << endl;
   debug(debug_suffix.str());
 
-  // Create data packet
-  ApplicationPacket p(current_term, sizeOfData);
+  // Start a transfer of the new dataset to every node. Chunks are built
+  // once and shared by all the followers
+  chunk_packets.clear();
+  transfers.assign(peers.size(),
+                   TransferSender((int) ceil(sizeOfData), CHUNK_SIZE, TRANSFER_WINDOW));
 
-  // Broadcast the packet. BroadcastPacket() takes care of handling which nodes
-  // to send to (only those in current partition)
-  BroadcastPacket(p);
+  // Send the first window to the nodes of the current partition
+  for (size_t i = 0; i < allNodes.size(); ++i) {
+    if (i != node->GetId() && allNodes[i].first){
+      SendChunks(i);
+    }
+  }
 
   // Start retransmissions for this cycle.
   Simulator::Schedule(Seconds(2), &Central::RetransmitData, this, current_term, 1);
@@ -240,10 +260,15 @@ void Central::RetransmitData(int term, int increment_count){
     if (i != node->GetId() && inGroup && (latestTermReplied < current_term)){ 
 	    // Node is in current group
       debug_suffix.str("");
-      debug_suffix << "Retransmitting to " << i;
+      debug_suffix << "Retransmitting to " << i << " : "
+        << transfers[i].GetAckedCount() << "/" << transfers[i].GetChunksCount()
+        << " chunks acknowledged, " << transfers[i].GetLostCount() << " lost";
       debug(debug_suffix.str());
 
-      SendData(sizeOfData, GetIpAddressFromId(i)); 
+      // Chunks not acknowledged since the last check are lost, only
+      // those are sent again
+      transfers[i].OnTimeout();
+      SendChunks(i);
       requireRetransmission = true;
     }
   }
@@ -271,19 +296,34 @@ int Central::GetIdFromIp(Ipv4Address ip) {
 }
 
 /**
- * Leader only. eend DATA packet of size sizeOfData to a specific follower node.
+ * Leader only. Send the DATA chunks the window of a specific follower
+ * node allows.
  */
-void Central::SendData(float sizeOfData, Ipv4Address destAddr){
-  
-  debug_suffix.str("");
-  debug_suffix << node->GetId() << " Sending data " << sizeOfData << " at term "
-	<< current_term << " to node " << GetIdFromIp(destAddr) << endl;
+void Central::SendChunks(int followerId){
+
   if (!running || !isLeader) {
     return;
   }
-  // Create data packet p of size sizeOfData, send to destAddr
-  ApplicationPacket p(current_term, sizeOfData);
-  SendPacket(p, destAddr, false);
+  Ipv4Address destAddr = GetIpAddressFromId(followerId);
+  for (int chunk : transfers[followerId].NextChunks()){
+    debug_suffix.str("");
+    debug_suffix << node->GetId() << " Sending chunk " << chunk << " of data " << sizeOfData
+      << " at term " << current_term << " to node " << followerId << endl;
+    debug(debug_suffix.str());
+
+    SendPacket(GetChunkPacket(chunk)->Copy(), destAddr);
+  }
+}
+
+Ptr<Packet> Central::GetChunkPacket(int chunk){
+  if (chunk_packets.size() <= (size_t) chunk){
+    chunk_packets.resize(chunk + 1);
+  }
+  if (!chunk_packets[chunk]){
+    ApplicationPacket p(current_term, sizeOfData, chunk);
+    chunk_packets[chunk] = p.ToPacket();
+  }
+  return chunk_packets[chunk];
 }
 
 
@@ -293,9 +333,43 @@ void Central::ProcessFollowerResponse(ApplicationPacket& p, Ipv4Address senderAd
   }
   int term = p.GetTerm();
   int followerId = GetIdFromIp(senderAddr);
-  
-  // Record that this follower replied for this term.
-  allNodes[followerId].second = term;
+  if (term != current_term || followerId < 0) {
+    return;
+  }
+
+  // The reply carries the chunks received, slide the window and send
+  // the next chunks or the lost ones
+  transfers[followerId].OnAck(p.GetPayload());
+  if (transfers[followerId].IsComplete()) {
+    // Record that this follower received the whole dataset for this term.
+    allNodes[followerId].second = term;
+  } else {
+    SendChunks(followerId);
+  }
+}
+
+void Central::ReceiveChunk(ApplicationPacket& p, Ipv4Address senderAddr){
+  int term = p.GetTerm();
+  if (term > reception_term) {
+    // New dataset: the buffer is allocated once for all its chunks
+    reception = TransferReceiver(p.GetDataSize(), CHUNK_SIZE);
+    reception_term = term;
+  }
+  if (term != reception_term || p.GetChunk() < 0 ||
+      p.GetChunk() >= reception.GetChunksCount()) {
+    return;
+  }
+
+  int chunk = p.GetChunk();
+  if (!reception.IsReceived(chunk)) {
+    p.GetPayloadPacket()->CopyData((uint8_t*) reception.GetChunkData(chunk),
+                                   reception.GetChunkSize(chunk));
+    reception.SetReceived(chunk);
+  }
+
+  // Duplicates are acknowledged too, the previous reply may have been lost
+  ApplicationPacket reply(term, reception.GetReceivedBitmap());
+  SendPacket(reply, senderAddr, false);
 }
 
 // Todo: some callback function for mobility/group discovery model to update nodes in group
@@ -26,6 +26,7 @@
 #include "block.h"
 #include "blockgraph.h"
 #include "b4m_traces.h"
+#include "data_transfer.h"
 
 #include <vector>
 #include <utility>
@@ -69,8 +70,20 @@ class Central : public Application{
 
     void SendPacket(ApplicationPacket& packet, Ipv4Address ip, bool scheduled=false);
 
+    /**
+     * Send an already built packet. The packet is handed to the socket,
+     * pass a Packet::Copy to send the same packet again.
+     */
+    void SendPacket(Ptr<Packet> pkt, Ipv4Address ip);
+
     void BroadcastPacket(ApplicationPacket& packet);
 
+    /**
+     * Return the socket connected to ip, creating it on first use.
+     * Sockets are kept until the application stops.
+     */
+    Ptr<Socket> GetPeerSocket(Ipv4Address ip);
+
     Ipv4Address GetIpAddressFromId(int id);
 
     int GetIdFromIp(Ipv4Address ip);
@@ -78,12 +91,28 @@ class Central : public Application{
     // Leader only
     void DisseminateData();
 
-    void SendData(float SizeOfData, Ipv4Address destAddr);
+    /**
+     * Send to the follower the chunks of the current dataset its window
+     * allows
+     */
+    void SendChunks(int followerId);
+
+    /**
+     * Return the packet of the chunk of the current dataset, built once
+     * per term. Send a Packet::Copy of it.
+     */
+    Ptr<Packet> GetChunkPacket(int chunk);
 
     void RetransmitData(int term, int increment_count);
 
     void ProcessFollowerResponse(ApplicationPacket& p, Ipv4Address senderAddr);
 
+    // Follower only
+    /**
+     * Write the chunk in the dataset being received and acknowledge it
+     */
+    void ReceiveChunk(ApplicationPacket& p, Ipv4Address senderAddr);
+
   private:
     // Leader specific variables:i
     bool isLeader; // Only one leader in the whole network.
@@ -93,10 +122,18 @@ class Central : public Application{
                               // Pair is <isInCurrentGroup, latestTermReplied>..
 
     float sizeOfData; // Current size of data to send
+    vector<TransferSender> transfers; // Transfer of the current dataset to each node
+    vector<Ptr<Packet>> chunk_packets; // Chunks of the current dataset already built
+
+    // Follower specific variables
+    TransferReceiver reception; // Dataset being received
+    int reception_term; // Term of the dataset being received
     
 
     // General variables
+    TypeId socket_tid; // ns3::UdpSocketFactory, looked up once in SetUp
     Ptr<Socket> recv_sock;
+    unordered_map<uint32_t, Ptr<Socket>> peer_socks; // peer ip -> connected socket
     Ptr<Node> node;
     vector<Ipv4Address> peers;
 
@@ -1,12 +1,21 @@
 #include "application_packet.h"
 #include <cstring>
+#include <cmath>
+#include <algorithm>
+
+NS_OBJECT_ENSURE_REGISTERED(ApplicationPacket);
 
 /**
  * Blank constructor?
  */
 ApplicationPacket::ApplicationPacket(){
   service = NULL;
+  term = -1;
+  chunk = 0;
+  chunksCount = 0;
+  dataSize = 0;
   payload = "";
+  virtualSize = 0;
 
   size = CalculateSize();
 }
@@ -14,86 +23,169 @@ ApplicationPacket::ApplicationPacket(){
 /**
  * Construct ApplicationPacket::Data
  * that leaders will send followers.
- * payload structure is [4 bytes: term][rest of data...]
+ * The term is in the header, the payload is [chunk data...]
  */
-ApplicationPacket::ApplicationPacket(int term, float dataSize) {
+ApplicationPacket::ApplicationPacket(int term, float dataSize, int chunk, int payloadMode) {
   service = DATA;
-  
-  // Start with the 4-byte term
-  payload.resize(sizeof(int));
-  memcpy(payload.data(), &term, sizeof(int));
-
-  // Pad with random bytes
-  for (float i = 0; i < dataSize; ++i) {
-    char randomByte = rand() % 256;
-    payload += randomByte;
+  this->term = term;
+  this->chunk = chunk;
+  this->dataSize = dataSize > 0 ? (int) ceil(dataSize) : 0;
+  chunksCount = (this->dataSize + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  virtualSize = 0;
+  size_t dataBytes = max(min(this->dataSize - chunk * CHUNK_SIZE, CHUNK_SIZE), 0);
+
+  if (payloadMode == VIRTUAL_PAYLOAD) {
+    // Nothing is stored
+    virtualSize = dataBytes;
+  } else {
+    // Copy the random bytes from the pool. The offset depends on the chunk
+    // only, so a resent chunk carries the same bytes
+    const string &pool = RandomPool();
+    payload.resize(dataBytes);
+    size_t offset = (size_t) chunk * CHUNK_SIZE % pool.size();
+    for (size_t i = 0; i < payload.size(); ) {
+      size_t n = min(pool.size() - offset, payload.size() - i);
+      memcpy(&payload[i], pool.data() + offset, n);
+      i += n;
+      offset = 0;
+    }
   }
+
   size = CalculateSize();
 
 }
 
 /**
- * Constructor for reply packet. 
- * Payload structure is [4 bytes term]
+ * Constructor for reply packet.
+ * No payload, the term is in the header
+ */
+ApplicationPacket::ApplicationPacket(int term) : ApplicationPacket(term, string()){
+}
+
+/**
+ * Constructor for reply packet acknowledging chunks.
+ * Payload structure is [bitmap of the received chunks]
  */
-ApplicationPacket::ApplicationPacket(int term) {
+ApplicationPacket::ApplicationPacket(int term, string received) {
   service = REPLY;
-  payload.resize(sizeof(int)); // Just need 4 bytes for the term
-  memcpy(payload.data(), &term, sizeof(int));
+  this->term = term;
+  chunk = 0;
+  chunksCount = 0;
+  dataSize = 0;
+  payload = move(received);
+  virtualSize = 0;
   size = CalculateSize();
 }
 
 /**
  * Copy constructor.
  */
-ApplicationPacket::ApplicationPacket(const ApplicationPacket &p){
+ApplicationPacket::ApplicationPacket(const ApplicationPacket &p) : Header(p){
   service = p.service;
+  term = p.term;
+  chunk = p.chunk;
+  chunksCount = p.chunksCount;
+  dataSize = p.dataSize;
   payload = p.payload;
+  virtualSize = p.virtualSize;
+  body = p.body;
   size = p.size;
 }
 
 /**
- * Constructs ApplicationPacket from serialised form.
+ * Constructs ApplicationPacket from a received packet.
  */
-ApplicationPacket::ApplicationPacket(string &serie){
-  packet_hdr_serie *hdr = (packet_hdr_serie*) serie.data();
-  service = hdr->service;
-  size = hdr->size;
+ApplicationPacket::ApplicationPacket(Ptr<Packet> packet){
+  packet->RemoveHeader(*this);
 
-  const char* packet_payload = serie.data() + HeaderSize();
-  payload = string(packet_payload, size-HeaderSize());
+  // Virtual bytes are received as zeros, they are part of the body
+  payload = "";
+  virtualSize = 0;
+  body = packet;
 }
 
 ApplicationPacket::~ApplicationPacket(){
 }
 
-int ApplicationPacket::GetTerm() {
-  if (payload.size() < sizeof(int)) {
-    return -1;
-  }
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+TypeId ApplicationPacket::GetTypeId(){
+  static TypeId tid = TypeId("ApplicationPacket")
+    .SetParent<Header>()
+    .SetGroupName("Application")
+    .AddConstructor<ApplicationPacket>()
+    ;
+  return tid;
+}
+
+TypeId ApplicationPacket::GetInstanceTypeId() const{
+  return GetTypeId();
+}
+
+uint32_t ApplicationPacket::GetSerializedSize() const{
+  return HEADER_SIZE;
+}
+
+void ApplicationPacket::Serialize(Buffer::Iterator start) const{
+  start.WriteHtonU32(size);
+  start.WriteU8(service);
+  start.WriteHtonU32(term);
+  start.WriteHtonU32(chunk);
+  start.WriteHtonU32(chunksCount);
+  start.WriteHtonU32(dataSize);
+}
+
+uint32_t ApplicationPacket::Deserialize(Buffer::Iterator start){
+  size = start.ReadNtohU32();
+  service = start.ReadU8();
+  term = start.ReadNtohU32();
+  chunk = start.ReadNtohU32();
+  chunksCount = start.ReadNtohU32();
+  dataSize = start.ReadNtohU32();
+  return HEADER_SIZE;
+}
+
+void ApplicationPacket::Print(ostream &os) const{
+  os << "service=" << (int)service << " size=" << size << " term=" << term
+     << " chunk=" << chunk << "/" << chunksCount << " dataSize=" << dataSize;
+}
 
-  int term;
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-  // Regardless of DATA or REPLY packet type, term is always the
-  // first 4 bytes of the payload anyway.
-  memcpy(&term, payload.data(), sizeof(int));
+int ApplicationPacket::GetTerm() {
   return term;
 }
 
+int ApplicationPacket::GetChunk() {
+  return chunk;
+}
+
+int ApplicationPacket::GetChunksCount() {
+  return chunksCount;
+}
+
+int ApplicationPacket::GetDataSize() {
+  return dataSize;
+}
+
 /**
  * Calculate the size of the SERIALIZED version of the packet
  */
 int ApplicationPacket::CalculateSize(){
-  return HeaderSize() + payload.size();
+  return HeaderSize() + payload.size() + virtualSize;
 }
 
 /**
- * Header contains: 
+ * Header contains:
  * int size
  * char service
+ * int term
+ * int chunk
+ * int chunksCount
+ * int dataSize
  */
 int ApplicationPacket::HeaderSize(){
-  return sizeof(char) + sizeof(int);
+  return HEADER_SIZE;
 }
 
 void ApplicationPacket::SetSize(int size){
@@ -114,26 +206,56 @@ char ApplicationPacket::GetService(){
 
 void ApplicationPacket::SetPayload(string payload){
   this->payload = payload;
+  body = 0;
 }
 
 string ApplicationPacket::GetPayload(){
+  if (body){
+    payload.resize(body->GetSize());
+    body->CopyData((uint8_t*) &payload[0], payload.size());
+    body = 0;
+  }
   return payload;
 }
 
+Ptr<Packet> ApplicationPacket::GetPayloadPacket(){
+  if (body)
+    return body;
+  return Create<Packet>((const uint8_t*) payload.data(), payload.size());
+}
 
-string ApplicationPacket::Serialize(){
-  string ret(HeaderSize(), 0);
-  packet_hdr_serie* p = (packet_hdr_serie*) ret.data();
+int ApplicationPacket::GetVirtualSize(){
+  return virtualSize;
+}
 
-  p->service = service;
-  p->size = size;
-  
-  ret = ret + payload;
-  return ret;
+const string& ApplicationPacket::RandomPool(){
+  static string pool;
+  if (pool.empty()){
+    pool.resize(RANDOM_POOL_SIZE);
+    for (auto &c : pool)
+      c = rand() % 256;
+  }
+  return pool;
+}
+
+
+Ptr<Packet> ApplicationPacket::ToPacket(){
+  Ptr<Packet> pkt;
+  if (body){
+    pkt = body->Copy();
+  } else if (payload.empty()){
+    // Zero-filled bytes, never allocated by ns-3
+    pkt = Create<Packet>(virtualSize);
+  } else {
+    pkt = Create<Packet>((const uint8_t*) payload.data(), payload.size());
+    if (virtualSize > 0)
+      pkt->AddAtEnd(Create<Packet>(virtualSize));
+  }
+  pkt->AddHeader(*this);
+  return pkt;
 }
 
 ostream& operator<<(ostream& o, const ApplicationPacket& p){
-  o << "Packet(" << (int)p.service << "," << p.size << "," << p.payload << ")";
+  o << "Packet(" << (int)p.service << "," << p.size << "," << p.term << "," << p.payload << ")";
   return o;
 }
-
@@ -5,35 +5,71 @@
 #include <cstdint>
 #include <cstring>
 
+#include "ns3/header.h"
+#include "ns3/packet.h"
 
-using namespace std;
+#include "configs.h"
 
-class ApplicationPacket{
-  public:
-    
-    // Header, used for serialised version of packet
-    typedef struct packet_hdr_serie{
-      int size; 
-      char service;
-    } packet_hdr_serie;
+using namespace ns3;
+using namespace std;
 
+/**
+ * Application header, followed in the ns-3 packet by the payload.
+ * Serialized header: size (4 bytes) | service (1 byte) | term (4 bytes) |
+ * chunk (4 bytes) | chunks count (4 bytes) | data size (4 bytes),
+ * integers in network order.
+ * A DATA packet carries one CHUNK_SIZE chunk of the dataset of the term.
+ * A REPLY packet carries the bitmap of the chunks the follower received.
+ */
+class ApplicationPacket : public Header{
   public:
     // Constants
     enum {DATA, REPLY};
+    // Payload modes of DATA packets
+    enum {RANDOM_PAYLOAD, VIRTUAL_PAYLOAD};
+    static const int HEADER_SIZE = 21;
+
   public:
     //Constructors and destructor
     ApplicationPacket();
     //ApplicationPacket(char service, string payload);
-    ApplicationPacket(int term, float dataSize); // Create data packet
+    /**
+     * Create a data packet carrying the given chunk of a dataset of
+     * dataSize bytes. In VIRTUAL_PAYLOAD mode the bytes are only counted:
+     * they are zeros added by ToPacket (see GetVirtualSize).
+     */
+    ApplicationPacket(int term, float dataSize, int chunk,
+                      int payloadMode = DATA_PAYLOAD_VIRTUAL ? VIRTUAL_PAYLOAD : RANDOM_PAYLOAD);
     ApplicationPacket(int term); // Create reply packet
+    /**
+     * Create a reply packet carrying the bitmap of the received chunks
+     */
+    ApplicationPacket(int term, string received);
     ApplicationPacket(const ApplicationPacket &p);
-    ApplicationPacket(string &serie);
+    /**
+     * Parse a received packet. The header is removed from packet in
+     * place and the rest is kept as the payload, which is only copied
+     * out by GetPayload.
+     */
+    ApplicationPacket(Ptr<Packet> packet);
     ~ApplicationPacket();
 
+  public:
+    // ns3::Header
+    static TypeId GetTypeId(void);
+    virtual TypeId GetInstanceTypeId(void) const;
+    virtual uint32_t GetSerializedSize(void) const;
+    virtual void Serialize(Buffer::Iterator start) const;
+    virtual uint32_t Deserialize(Buffer::Iterator start);
+    virtual void Print(ostream &os) const;
+
   public:
     // Getters, Setters and Operators;
-    
+
     int GetTerm();
+    int GetChunk();
+    int GetChunksCount();
+    int GetDataSize();
 
     void SetSize(int size);
     int GetSize();
@@ -41,6 +77,15 @@ class ApplicationPacket{
     char GetService();
     void SetPayload(string payload);
     string GetPayload();
+    /**
+     * Get the payload as a packet, without copying it
+     */
+    Ptr<Packet> GetPayloadPacket();
+    /**
+     * Get the number of zero bytes that follow the payload on the wire
+     * but are not stored in the packet
+     */
+    int GetVirtualSize();
 
     ostream& operator<<(const ostream& o);
     friend ostream& operator<<(ostream& o, const ApplicationPacket& p);
@@ -56,15 +101,29 @@ class ApplicationPacket{
     int HeaderSize();
 
     /**
-     * Serialize the packet into an array of byte (here a string is more
-     * convenient)
+     * Build the ns-3 packet: the payload is written once into the packet
+     * buffer, the virtual bytes are zero-filled by ns-3 and the header is
+     * serialized in front of them. Copies of the result made with
+     * Packet::Copy share its buffer.
      */
-    string Serialize();
+    Ptr<Packet> ToPacket();
 
   private:
     char service; // Service identifier of the packet (DATA, REPLY}
     int size; // Size of the whole packet (INCLUDING HEADER!!!)
+    int term; // Term of the leader sending the data, or being replied to
+    int chunk; // Index of the chunk carried by a DATA packet
+    int chunksCount; // Number of chunks of the dataset
+    int dataSize; // Size of the whole dataset
     string payload; // Payload of the packet (contains an application message
+    int virtualSize; // Zero bytes following the payload, not stored
+    Ptr<Packet> body; // Received payload, not copied yet
+
+  private:
+    /**
+     * Return the pool of random bytes, generated on first use
+     */
+    static const string& RandomPool();
 
 };
 
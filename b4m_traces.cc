@@ -41,6 +41,13 @@ void B4MTraces::ReceivedBlockInfo(pair<pair<int, int>, pair<int, double> > block
   block_creation.push_back(block_creation_rate);
 }
 
+void B4MTraces::DuplicatedTxs(pair<float, int> new_value){
+  if (duplicated_txs.count(new_value.first) >= 1)
+    duplicated_txs[new_value.first] += new_value.second;
+  else
+    duplicated_txs.insert(new_value);
+}
+
 void B4MTraces::ReceivedBytes(pair<float, int> new_value){
 //  cerr << "Received " << new_value.second << " bytes at " << new_value.first <<
 //    "s" << endl;
@@ -93,6 +100,7 @@ string B4MTraces::PrintSummary(){
   int total_bytes_sent = 0;
   int total_messages_received = 0;
   int total_messages_sent = 0;
+  int total_duplicated_txs = 0;
 
   for (auto r : received_bytes)
     total_bytes_received += r.second;
@@ -106,10 +114,14 @@ string B4MTraces::PrintSummary(){
   for (auto r : sent_messages)
     total_messages_sent += r.second;
 
+  for (auto r : duplicated_txs)
+    total_duplicated_txs += r.second;
+
   ret << "Total bytes received : " << total_bytes_received << endl;
   ret << "Total bytes sent : " << total_bytes_sent << endl;
   ret << "Total messages received : " << total_messages_received << endl;
   ret << "Total messages sent : " << total_messages_sent << endl;
+  ret << "Total duplicated transactions : " << total_duplicated_txs << endl;
 
   return ret.str();
 }
@@ -154,4 +166,12 @@ void B4MTraces::ExportResults(){
   }
   output_file.close();
 
+  // Exports the transactions duplicated across branches at each join
+  sprintf(filename, "scratch/b4mesh/Traces/DuplicatedTxs.txt");
+  output_file.open(filename, ios::out);
+  output_file << "#Time" << " " << "NumDuplicatedTxs" << endl;
+  for (auto &it : duplicated_txs)
+    output_file << it.first << " " << it.second << endl;
+  output_file.close();
+
 }
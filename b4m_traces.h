@@ -27,6 +27,9 @@ class B4MTraces{
      * Traces for B4Mesh
      */
     void ReceivedBlockInfo(pair<pair<int, int>, pair<int, double>> block_creation_rate);
+
+    // Register transactions found in several branches when they are joined
+    void DuplicatedTxs(pair<float, int> new_value);
   
 
     // Register sent and received bytes/messages
@@ -76,6 +79,7 @@ class B4MTraces{
     vector<pair<pair<int, int>, pair<int, double>>> block_creation;
     //vector<pair<int,pair<int,int>>> blockgraph_file;
     vector<pair<double,pair<string,int>>> txs_per_block;
+    map<float, int> duplicated_txs;
 
 
 };
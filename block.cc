@@ -1,4 +1,5 @@
 #include "block.h"
+#include "block_view.h"
 
 
 Block::Block(){
@@ -11,6 +12,7 @@ Block::Block(){
   blockType = regBlock; // new
   transactions = vector<Transaction>();
 
+  BuildMerkleTree();
   size = CalculateSize();
   CalculateHash();
 }
@@ -19,76 +21,34 @@ Block::Block(string hash, int index, int leader, int blockType, string groupId,
              vector<string> parents, double timestamp,
              vector<Transaction> transactions){
 
-  this->hash =                 hash + string(HASH_SIZE - hash.size(), '1');
+  this->hash =                 move(hash);
+  this->hash.resize(max<size_t>(this->hash.size(), HASH_SIZE), '1');
   this->index =                index;
   this->leader =               leader;
   this->blockType =            blockType;   // new
-  this->groupId = groupId + string(HASH_SIZE - groupId.size(), '0');
-  this->parents =              parents;
+  this->groupId =              move(groupId);
+  this->groupId.resize(max<size_t>(this->groupId.size(), HASH_SIZE), '0');
+  this->parents =              move(parents);
   this->timestamp =            timestamp;
-  this->transactions =         transactions;
+  this->transactions =         move(transactions);
 
+  BuildMerkleTree();
   size = CalculateSize();
 
 }
 
-Block::Block(const Block &b){
-
-  hash =                 b.hash;
-  index =                b.index;
-  leader =               b.leader;
-  blockType =            b.blockType;   // new
-  groupId =              b.groupId;
-  parents =              b.parents;
-  timestamp =            b.timestamp;
-  transactions =         b.transactions;
-  size =                 b.size;
-}
-
-Block::Block(const string &serie){
-  const block_t *p = (block_t*) serie.data();
-
-  hash = string(p->hash, HASH_SIZE);
-  index = p->index;
-  leader = p->leader;
-  blockType = p->blockType;   // new
-  groupId = string(p->groupId, HASH_SIZE);
-  timestamp = p->timestamp;
-  size = p->size;
-
-  int tx_count = p->tx_count;
-  int parents_count = p->parents_count;
-
-  const char *p_parents = (const char*) p + sizeof(block_t);
-  for(int i=0; i<parents_count*HASH_SIZE; i += HASH_SIZE)
-    parents.push_back(string(p_parents+i, HASH_SIZE));
-
-  const char *p_transactions = p_parents + parents_count * HASH_SIZE;
-  int transactions_offset = 0;
-  int remaining_bytes = serie.size() - (p_transactions - (const char*)p);
-  for (int i=0; i<tx_count; ++i){
-    Transaction t(string(p_transactions+transactions_offset, remaining_bytes));
-    transactions.push_back(t);
-    transactions_offset += t.GetSize();
-    remaining_bytes -= t.GetSize();
-  }
-
-  size = CalculateSize();
+Block::Block(const string &serie) : Block(BlockView(serie).ToBlock()){
 }
 
-Block::~Block(){
-
-}
-
-string Block::GetHash() const{
+const string& Block::GetHash() const{
   return hash;
 }
 
 void Block::SetHash(string hash){
-  this->hash = hash;
+  this->hash = move(hash);
 }
 
-int Block::GetIndex(){
+int Block::GetIndex() const{
   return index;
 }
 
@@ -97,7 +57,7 @@ void Block::SetIndex(int index){
   CalculateHash();
 }
 
-int Block::GetLeader(){
+int Block::GetLeader() const{
   return leader;
 }
 
@@ -107,7 +67,7 @@ void Block::SetLeader(int leader){
 }
 
 // new function
-int Block::GetBlockType(){
+int Block::GetBlockType() const{
   return blockType;
 }
 
@@ -117,30 +77,31 @@ void Block::SetBlockType(int type){
   CalculateHash();
 }
 
-string Block::GetGroupId(){
+const string& Block::GetGroupId() const{
   return groupId;
 }
 
 void Block::SetGroupId(string groupId){
-  this->groupId = groupId + string(HASH_SIZE - groupId.size(), 0);
+  groupId.resize(max<size_t>(groupId.size(), HASH_SIZE), 0);
+  this->groupId = move(groupId);
   CalculateHash();
 }
 
-vector<string> Block::GetParents() const{
+const vector<string>& Block::GetParents() const{
   return parents;
 }
 
 void Block::SetParents(vector<string> parents){
-  this->parents = parents;
+  this->parents = move(parents);
 
   for (auto &p : this->parents)
-    p = p + string(HASH_SIZE - p.size(), 0);
+    p.resize(max<size_t>(p.size(), HASH_SIZE), 0);
 
   size = CalculateSize();
   CalculateHash();
 }
 
-double Block::GetTimestamp(){
+double Block::GetTimestamp() const{
   return timestamp;
 }
 
@@ -149,17 +110,33 @@ void Block::SetTimestamp(double timestamp){
   CalculateHash();
 }
 
-vector<Transaction> Block::GetTransactions() const{
+const vector<Transaction>& Block::GetTransactions() const{
   return transactions;
 }
 
+const Transaction& Block::GetTransaction(int i) const{
+  return transactions[i];
+}
+
 void Block::SetTransactions(vector<Transaction> transactions){
-  this->transactions = transactions;
+  this->transactions = move(transactions);
+  BuildMerkleTree();
   size = CalculateSize();
   CalculateHash();
 }
 
-int Block::GetSize(){
+void Block::SetTransaction(int i, Transaction transaction){
+  transactions[i] = move(transaction);
+  UpdateMerklePath(i);
+  size = CalculateSize();
+  CalculateHash();
+}
+
+string Block::GetMerkleRoot() const{
+  return merkle.back()[0].ToString();
+}
+
+int Block::GetSize() const{
   return size;
 }
 
@@ -169,7 +146,7 @@ void Block::SetSize(int size){
 }
 
 bool Block::IsParent(Block &block){
-  for (string p_hash : block.GetParents()){
+  for (auto &p_hash : block.GetParents()){
     if(GetHash() == p_hash)
       return true;
   }
@@ -222,24 +199,86 @@ bool Block::IsMergeBlock (vector<string> parents) {
 */
 string Block::CalculateHash(){
   hash = string(HASH_SIZE, 0);
-  string serie = Serialize();
-  hash = hashing(serie, HASH_SIZE);
+  string serie(sizeof(block_t) + parents.size() * HASH_SIZE, 0);
+  WriteHeader(&serie[0]);
+  hash = HashEngine::Digest(HashEngine::SHA256, serie, HASH_SIZE);
   return hash;
 
 }
 
-Block& Block::operator= (const Block &b){
-  hash =                 b.hash;
-  index =                b.index;
-  leader =               b.leader;
-  blockType =            b.blockType;   // new
-  groupId =              b.groupId;
-  parents =              b.parents;
-  timestamp =            b.timestamp;
-  transactions =         b.transactions;
-  size =                 b.size;
+vector<string> Block::GetMerkleProof(int i) const{
+  vector<string> proof;
+  for (size_t level = 0; level + 1 < merkle.size(); ++level){
+    size_t sibling = i ^ 1;
+    if (sibling >= merkle[level].size())
+      sibling = i;
+    proof.push_back(merkle[level][sibling].ToString());
+    i /= 2;
+  }
+  return proof;
+}
+
+bool Block::VerifyMerkleProof(const Transaction &transaction, int i,
+                              const vector<string> &proof, string merkleRoot){
+  BlockHash node = HashTransaction(transaction);
+  for (auto &p : proof){
+    if (i % 2 == 0)
+      node = HashPair(node, BlockHash(p));
+    else
+      node = HashPair(BlockHash(p), node);
+    i /= 2;
+  }
+  return node == BlockHash(merkleRoot);
+}
+
+void Block::BuildMerkleTree(){
+  merkle.assign(1, vector<BlockHash>());
+  merkle[0].reserve(transactions.size());
+  for (auto &t : transactions)
+    merkle[0].push_back(HashTransaction(t));
+
+  if (merkle[0].empty()){
+    // Root of a block without transactions
+    merkle[0].push_back(BlockHash());
+    return;
+  }
+
+  while (merkle.back().size() > 1){
+    const vector<BlockHash> &below = merkle.back();
+    vector<BlockHash> level;
+    level.reserve((below.size() + 1) / 2);
+    for (size_t k = 0; k < below.size(); k += 2)
+      level.push_back(HashPair(below[k], below[k + 1 < below.size() ? k + 1 : k]));
+    merkle.push_back(level);
+  }
+}
+
+void Block::UpdateMerklePath(int i){
+  merkle[0][i] = HashTransaction(transactions[i]);
+  for (size_t level = 1; level < merkle.size(); ++level){
+    const vector<BlockHash> &below = merkle[level - 1];
+    size_t left = i & ~1;
+    size_t right = left + 1 < below.size() ? left + 1 : left;
+    i /= 2;
+    merkle[level][i] = HashPair(below[left], below[right]);
+  }
+}
+
+BlockHash Block::HashTransaction(const Transaction &transaction){
+  string serie(transaction.SerializedSize(), 0);
+  transaction.SerializeTo(&serie[0]);
+  BlockHash ret;
+  HashEngine::Digest(HashEngine::SHA256, serie.data(), serie.size(), (char*) ret.data(), HASH_SIZE);
+  return ret;
+}
 
-  return *this;
+BlockHash Block::HashPair(const BlockHash &left, const BlockHash &right){
+  char serie[2 * HASH_SIZE];
+  memcpy(serie, left.data(), HASH_SIZE);
+  memcpy(serie + HASH_SIZE, right.data(), HASH_SIZE);
+  BlockHash ret;
+  HashEngine::Digest(HashEngine::SHA256, serie, sizeof(serie), (char*) ret.data(), HASH_SIZE);
+  return ret;
 }
 
 bool Block::operator==(const Block &b){
@@ -271,8 +310,59 @@ ostream& operator<<(std::ostream &out, const Block &b){
 }
 
 string Block::Serialize(){
-  string ret = "";
+  string ret(SerializedSize(), 0);
+  SerializeTo(&ret[0]);
+  return ret;
+}
+
+size_t Block::SerializedSize() const{
+  size_t ret = sizeof(block_t);
+  ret += parents.size() * HASH_SIZE;
+  ret += transactions.size() * sizeof(uint32_t);
+  for (auto &t : transactions)
+    ret += t.SerializedSize();
+  return ret;
+}
+
+char* Block::SerializeTo(char *buffer) const{
+  buffer = SerializeHeader(buffer);
+  for (auto &t : transactions)
+    buffer = t.SerializeTo(buffer);
+  return buffer;
+}
+
+void Block::SerializeIov(string &headers, vector<iovec> &iov) const{
+  // Sized once so that iov can point into it
+  headers.assign(sizeof(block_t) + parents.size() * HASH_SIZE +
+                 transactions.size() * (sizeof(uint32_t) + sizeof(Transaction::tx_t)), 0);
+
+  char *p = &headers[0];
+  char *end = SerializeHeader(p);
+  iov.push_back({p, (size_t)(end - p)});
+  p = end;
+
+  for (auto &t : transactions){
+    t.SerializeIov(p, iov);
+    p += sizeof(Transaction::tx_t);
+  }
+}
+
+char* Block::SerializeHeader(char *buffer) const{
+  char *p = WriteHeader(buffer);
+
+  // Offset table: position of each transaction from the start of the block
+  uint32_t offset = (p - buffer) + transactions.size() * sizeof(uint32_t);
+  for (auto &t : transactions){
+    memcpy(p, &offset, sizeof(offset));
+    p += sizeof(offset);
+    offset += t.SerializedSize();
+  }
+  return p;
+}
+
+char* Block::WriteHeader(char *buffer) const{
   block_t header;
+  memset(&header, 0, sizeof(header));
 
   header.timestamp = timestamp;
   header.size = size;
@@ -282,33 +372,36 @@ string Block::Serialize(){
   header.parents_count = parents.size();
   header.tx_count = transactions.size();
 
-  memcpy(header.groupId, groupId.data(), groupId.size());
-  memcpy(header.hash, hash.data(), hash.size());
+  memcpy(header.groupId, groupId.data(), min<size_t>(groupId.size(), HASH_SIZE));
+  memcpy(header.hash, hash.data(), min<size_t>(hash.size(), HASH_SIZE));
+  memcpy(header.merkleRoot, merkle.back()[0].data(), HASH_SIZE);
 
-  ret = ret + string((char*) &header, sizeof(header));
+  memcpy(buffer, &header, sizeof(header));
+  char *p = buffer + sizeof(header);
 
-  for (auto p : parents)
-    ret = ret + p;
-  for (auto t : transactions){
-    ret = ret + t.Serialize();
+  for (auto &h : parents){
+    size_t n = min<size_t>(h.size(), HASH_SIZE);
+    memcpy(p, h.data(), n);
+    memset(p + n, 0, HASH_SIZE - n);
+    p += HASH_SIZE;
   }
-  return ret;
+  return p;
 }
 
-int Block::GetTxsCount(){
+int Block::GetTxsCount() const{
   return transactions.size();
 }
 
 int Block::CalculateSize(){
   int ret = CalculateHeaderSize();
-  for (auto t : transactions)
+  for (const auto &t : transactions)
     ret += t.GetSize();
   return ret;
 }
 
-int Block::CalculeTxsSize(){
+int Block::CalculeTxsSize() const{
   int ret = 0;
-  for (auto t : transactions)
+  for (const auto &t : transactions)
     ret += t.GetSize();
   return ret;
 }
@@ -322,6 +415,8 @@ int Block::CalculateHeaderSize(){
   ret += sizeof(blockType);     // new
   ret += sizeof(timestamp);
   ret += HASH_SIZE;
+  // The Merkle root is left out so that block, blockgraph and trace sizes
+  // stay comparable with the runs made before it was added
   ret += parents.size() * HASH_SIZE;
 
   return ret;
@@ -15,6 +15,8 @@ class Block{
 
   public:
     // Typedef
+    // Serialized block: block_t | parents_count hashes | tx_count uint32_t
+    // offsets of the transactions from the start of the block | transactions
     typedef struct block_t{
       double              timestamp;  // time of creation of a block
       int                 size;  // size of block expresed in bytes
@@ -25,6 +27,7 @@ class Block{
       int                blockType;   // new
       char                groupId[HASH_SIZE]; // Id of the group that validated the block  //[HASH_SIZE]
       char                hash[HASH_SIZE]; // hash of the current block  /[HASH_SIZE]
+      char                merkleRoot[HASH_SIZE]; // root of the merkle tree of the transactions
     } block_t;
 
 
@@ -34,44 +37,54 @@ class Block{
     Block(string hash, int index, int leader, int blockType, string groupId,  // new
           vector<string> parents, double timestamp,
           vector<Transaction> transactions);
-    Block(const Block &b);
+    Block(const Block &b) = default;
+    Block(Block &&b) = default;
     Block(const string &serie);
-    ~Block();
+    ~Block() = default;
 
   public:
     //Getters, Setters & Operators
-    string GetHash (void) const;
+    const string& GetHash (void) const;
     void SetHash (string hash);
 
-    int GetIndex (void);
+    int GetIndex (void) const;
     void SetIndex (int index);
 
-    int GetLeader (void);
+    int GetLeader (void) const;
     void SetLeader (int leader);
 
-    string GetGroupId (void);
+    const string& GetGroupId (void) const;
     void SetGroupId (string groupId);
 
-    vector<string> GetParents (void) const;
+    const vector<string>& GetParents (void) const;
     void SetParents (vector<string> parents);
 
-    double GetTimestamp (void);
+    double GetTimestamp (void) const;
     void SetTimestamp (double timestamp);
 
-    int GetBlockType (void);
+    int GetBlockType (void) const;
     void SetBlockType (int type);
 
-    vector<Transaction> GetTransactions (void) const;
+    const vector<Transaction>& GetTransactions (void) const;
     void SetTransactions (vector<Transaction> transactions);
+    const Transaction& GetTransaction (int i) const;
+    /**
+     * Replace the i-th transaction. Only the merkle path of the
+     * transaction is recomputed.
+     */
+    void SetTransaction (int i, Transaction transaction);
+
+    string GetMerkleRoot (void) const;
 
-    int GetSize (void);
+    int GetSize (void) const;
     void SetSize (int size);
 
-    int GetTxsCount();
+    int GetTxsCount() const;
 
     bool operator==(const Block &b);
     friend std::ostream& operator<< (std::ostream &out, const Block &block);
-    Block& operator= (const Block &block2);
+    Block& operator= (const Block &block2) = default;
+    Block& operator= (Block &&block2) = default;
 
 
   public:
@@ -102,10 +115,24 @@ class Block{
     bool IsMergeBlock (vector<string> parents);
 
     /*
-     * Calculate the hash of the block
+     * Calculate the hash of the block. The hash covers the header, the
+     * parents and the merkle root of the transactions, not their payloads.
      */
     string CalculateHash ();
 
+    /**
+     * Return the hashes of the siblings on the path from the i-th
+     * transaction to the merkle root, from the bottom up
+     */
+    vector<string> GetMerkleProof (int i) const;
+
+    /**
+     * Checks that the transaction is the i-th one of the block whose
+     * merkle root is given
+     */
+    static bool VerifyMerkleProof (const Transaction &transaction, int i,
+                                   const vector<string> &proof, string merkleRoot);
+
     /**
      * Calculate and return the block size
      */
@@ -114,7 +141,7 @@ class Block{
     /**
     * Calculate and return the size of transactions in block
     */
-    int CalculeTxsSize();
+    int CalculeTxsSize() const;
 
     /**
      * Calculate and return the block header size
@@ -126,6 +153,52 @@ class Block{
      */
     string Serialize();
 
+    /**
+     * Return the number of bytes written by SerializeTo
+     */
+    size_t SerializedSize() const;
+
+    /**
+     * Write the serialized block to buffer, which must hold
+     * SerializedSize() bytes. Return the end of the written bytes.
+     */
+    char* SerializeTo(char *buffer) const;
+
+    /**
+     * Scatter-gather form of SerializeTo. headers receives every byte that
+     * is not a transaction payload and iov references, in order, headers and
+     * the payloads of the block, which are not copied. Both headers and the
+     * block must outlive iov.
+     */
+    void SerializeIov(string &headers, vector<iovec> &iov) const;
+
+  private:
+    /**
+     * Write the block header and the parents.
+     * Return the end of the written bytes.
+     */
+    char* WriteHeader(char *buffer) const;
+
+    /**
+     * Write the block header, the parents and the transaction offset table.
+     * Return the end of the written bytes.
+     */
+    char* SerializeHeader(char *buffer) const;
+
+    /**
+     * Rebuild the merkle tree from the transactions
+     */
+    void BuildMerkleTree();
+
+    /**
+     * Recompute the merkle path of the i-th transaction
+     */
+    void UpdateMerklePath(int i);
+
+    static FixedHash<HASH_SIZE> HashTransaction(const Transaction &transaction);
+    static FixedHash<HASH_SIZE> HashPair(const FixedHash<HASH_SIZE> &left,
+                                         const FixedHash<HASH_SIZE> &right);
+
   private:
 
     string              hash;
@@ -137,6 +210,11 @@ class Block{
     vector<Transaction> transactions;
     int                 size;
     int                blockType;  // new
+    // Cached merkle tree: level 0 holds the transaction digests and the
+    // last level the root. An odd node is paired with itself.
+    vector<vector<FixedHash<HASH_SIZE>>> merkle;
 };
 
+typedef FixedHash<Block::HASH_SIZE> BlockHash;
+
 #endif
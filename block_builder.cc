@@ -0,0 +1,100 @@
+#include "block_builder.h"
+
+TransactionBuilder::TransactionBuilder(){
+  timestamp = 0.0;
+}
+
+TransactionBuilder& TransactionBuilder::SetPayload(string payload){
+  this->payload = move(payload);
+  return *this;
+}
+
+TransactionBuilder& TransactionBuilder::SetTimestamp(double timestamp){
+  this->timestamp = timestamp;
+  return *this;
+}
+
+Transaction TransactionBuilder::Build(){
+  // The constructor computes the size and the hash once
+  Transaction ret(string(Transaction::HASH_SIZE, 0), 0, move(payload), timestamp);
+  payload = "";
+  timestamp = 0.0;
+  return ret;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+BlockBuilder::BlockBuilder(){
+  Reset();
+}
+
+BlockBuilder& BlockBuilder::SetIndex(int index){
+  this->index = index;
+  return *this;
+}
+
+BlockBuilder& BlockBuilder::SetLeader(int leader){
+  this->leader = leader;
+  return *this;
+}
+
+BlockBuilder& BlockBuilder::SetBlockType(int type){
+  this->blockType = type;
+  return *this;
+}
+
+BlockBuilder& BlockBuilder::SetGroupId(string groupId){
+  // Padded like Block::SetGroupId
+  groupId.resize(max<size_t>(groupId.size(), Block::HASH_SIZE), 0);
+  this->groupId = move(groupId);
+  return *this;
+}
+
+BlockBuilder& BlockBuilder::SetParents(vector<string> parents){
+  this->parents = move(parents);
+  for (auto &p : this->parents)
+    p.resize(max<size_t>(p.size(), Block::HASH_SIZE), 0);
+  return *this;
+}
+
+BlockBuilder& BlockBuilder::AddParent(string parent){
+  // Padded like Block::SetParents
+  parent.resize(max<size_t>(parent.size(), Block::HASH_SIZE), 0);
+  parents.push_back(move(parent));
+  return *this;
+}
+
+BlockBuilder& BlockBuilder::SetTimestamp(double timestamp){
+  this->timestamp = timestamp;
+  return *this;
+}
+
+BlockBuilder& BlockBuilder::SetTransactions(vector<Transaction> transactions){
+  this->transactions = move(transactions);
+  return *this;
+}
+
+BlockBuilder& BlockBuilder::AddTransaction(Transaction transaction){
+  transactions.push_back(move(transaction));
+  return *this;
+}
+
+shared_ptr<const Block> BlockBuilder::Build(){
+  // The constructor builds the merkle tree and the size once
+  shared_ptr<Block> ret = make_shared<Block>(string(Block::HASH_SIZE, 0), index, leader,
+                                             blockType, move(groupId), move(parents),
+                                             timestamp, move(transactions));
+  ret->CalculateHash();
+  Reset();
+  return ret;
+}
+
+void BlockBuilder::Reset(){
+  index = 0;
+  leader = 0;
+  blockType = Block::regBlock;
+  groupId = string(Block::HASH_SIZE, 0);
+  parents = vector<string>();
+  timestamp = 0.0;
+  transactions = vector<Transaction>();
+}
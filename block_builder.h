@@ -0,0 +1,73 @@
+#ifndef BLOCK_BUILDER_H
+#define BLOCK_BUILDER_H
+#include <string>
+#include <vector>
+#include <memory>
+#include "block.h"
+#include "transaction.h"
+
+using namespace std;
+
+/**
+ * Collects the fields of a transaction and computes its size and hash
+ * once, in Build(), instead of after every setter.
+ */
+class TransactionBuilder{
+
+  public:
+    TransactionBuilder();
+
+  public:
+    TransactionBuilder& SetPayload (string payload);
+    TransactionBuilder& SetTimestamp (double timestamp);
+
+    /**
+     * Build the transaction and reset the builder
+     */
+    Transaction Build ();
+
+  private:
+    string    payload;
+    double    timestamp;
+};
+
+/**
+ * Collects the fields of a block and computes its merkle tree, size and
+ * hash once, in Build(), instead of after every setter.
+ */
+class BlockBuilder{
+
+  public:
+    BlockBuilder();
+
+  public:
+    BlockBuilder& SetIndex (int index);
+    BlockBuilder& SetLeader (int leader);
+    BlockBuilder& SetBlockType (int type);
+    BlockBuilder& SetGroupId (string groupId);
+    BlockBuilder& SetParents (vector<string> parents);
+    BlockBuilder& AddParent (string parent);
+    BlockBuilder& SetTimestamp (double timestamp);
+    BlockBuilder& SetTransactions (vector<Transaction> transactions);
+    BlockBuilder& AddTransaction (Transaction transaction);
+
+    /**
+     * Build the immutable block and reset the builder.
+     * The result can be given as is to Blockgraph::AddBlock.
+     */
+    shared_ptr<const Block> Build ();
+
+  private:
+    void Reset ();
+
+  private:
+    int                 index;
+    int                 leader;
+    int                 blockType;
+    string              groupId;
+    vector<string>      parents;
+    double              timestamp;
+    vector<Transaction> transactions;
+};
+
+#endif
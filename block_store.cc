@@ -0,0 +1,237 @@
+#include "block_store.h"
+#include "block_view.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char STORE_MAGIC[8] = {'B', '4', 'M', 'S', 'T', 'O', 'R', 0};
+static const uint64_t STORE_MIN_CAPACITY = 1024;
+
+BlockStore::BlockStore(size_t cacheCapacity){
+  log_fd = -1;
+  log_size = 0;
+  idx_fd = -1;
+  idx = nullptr;
+  idx_length = 0;
+  this->cacheCapacity = cacheCapacity;
+}
+
+BlockStore::~BlockStore(){
+  Close();
+}
+
+bool BlockStore::Open(string path){
+  Close();
+  this->path = path;
+
+  log_fd = open((path + ".log").c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  idx_fd = open((path + ".idx").c_str(), O_RDWR | O_CREAT, 0644);
+  if (log_fd < 0 || idx_fd < 0){
+    Close();
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(log_fd, &st) != 0){
+    Close();
+    return false;
+  }
+  log_size = st.st_size;
+
+  if (fstat(idx_fd, &st) != 0){
+    Close();
+    return false;
+  }
+
+  if (st.st_size == 0){
+    // New store
+    idx = MapIndex(idx_fd, STORE_MIN_CAPACITY);
+    if (idx == nullptr){
+      Close();
+      return false;
+    }
+    idx_length = IndexLength(STORE_MIN_CAPACITY);
+    memcpy(idx->magic, STORE_MAGIC, sizeof(idx->magic));
+    idx->capacity = STORE_MIN_CAPACITY;
+    idx->count = 0;
+    return true;
+  }
+
+  store_hdr_t hdr;
+  if (pread(idx_fd, &hdr, sizeof(hdr), 0) != (ssize_t) sizeof(hdr) ||
+      memcmp(hdr.magic, STORE_MAGIC, sizeof(hdr.magic)) != 0 ||
+      (off_t)(sizeof(hdr) + hdr.capacity * sizeof(store_entry_t)) != st.st_size){
+    Close();
+    return false;
+  }
+  idx = MapIndex(idx_fd, hdr.capacity);
+  if (idx == nullptr){
+    Close();
+    return false;
+  }
+  idx_length = IndexLength(hdr.capacity);
+  return true;
+}
+
+bool BlockStore::Put(shared_ptr<const Block> block){
+  BlockHash hash(block->GetHash());
+  if (idx == nullptr)
+    return false;
+  if (Contains(hash))
+    return true;
+
+  if ((idx->count + 1) * 2 > idx->capacity && !GrowIndex())
+    return false;
+
+  string serie(block->SerializedSize(), 0);
+  block->SerializeTo(&serie[0]);
+  if (write(log_fd, serie.data(), serie.size()) != (ssize_t) serie.size())
+    return false;
+
+  store_entry_t *e = Probe(hash);
+  memcpy(e->hash, hash.data(), Block::HASH_SIZE);
+  e->offset = log_size;
+  e->length = serie.size();
+  e->used = 1;
+  idx->count++;
+  log_size += serie.size();
+
+  Cache(hash, block);
+  return true;
+}
+
+bool BlockStore::Contains(const BlockHash &hash) const{
+  if (idx == nullptr)
+    return false;
+  return Probe(hash)->used != 0;
+}
+
+shared_ptr<const Block> BlockStore::Get(const BlockHash &hash){
+  auto it = cache.find(hash);
+  if (it != cache.end()){
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->second;
+  }
+
+  if (idx == nullptr)
+    return nullptr;
+  store_entry_t *e = Probe(hash);
+  if (!e->used)
+    return nullptr;
+
+  string serie(e->length, 0);
+  if (pread(log_fd, &serie[0], e->length, e->offset) != (ssize_t) e->length)
+    return nullptr;
+
+  BlockView view(serie);
+  if (!view.IsValid())
+    return nullptr;
+  shared_ptr<const Block> block = make_shared<const Block>(view.ToBlock());
+  Cache(hash, block);
+  return block;
+}
+
+size_t BlockStore::GetBlocksCount() const{
+  return idx == nullptr ? 0 : idx->count;
+}
+
+size_t BlockStore::GetCacheSize() const{
+  return lru.size();
+}
+
+size_t BlockStore::IndexLength(uint64_t capacity){
+  return sizeof(store_hdr_t) + capacity * sizeof(store_entry_t);
+}
+
+BlockStore::store_hdr_t* BlockStore::MapIndex(int fd, uint64_t capacity){
+  size_t length = IndexLength(capacity);
+  if (ftruncate(fd, length) != 0)
+    return nullptr;
+  void *m = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (m == MAP_FAILED)
+    return nullptr;
+  return (store_hdr_t*) m;
+}
+
+bool BlockStore::GrowIndex(){
+  // The larger index is built in a temporary file which replaces the
+  // current one only once it is complete. On failure the current index
+  // stays mapped and usable.
+  string tmp = path + ".idx.tmp";
+  int fd = open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return false;
+  uint64_t capacity = idx->capacity * 2;
+  store_hdr_t *grown = MapIndex(fd, capacity);
+  if (grown == nullptr){
+    close(fd);
+    unlink(tmp.c_str());
+    return false;
+  }
+
+  memcpy(grown->magic, STORE_MAGIC, sizeof(grown->magic));
+  grown->capacity = capacity;
+  grown->count = 0;
+  store_entry_t *slots = (store_entry_t*) (idx + 1);
+  for (uint64_t i = 0; i < idx->capacity; ++i){
+    if (slots[i].used){
+      *Probe(grown, BlockHash(slots[i].hash)) = slots[i];
+      grown->count++;
+    }
+  }
+
+  if (rename(tmp.c_str(), (path + ".idx").c_str()) != 0){
+    munmap(grown, IndexLength(capacity));
+    close(fd);
+    unlink(tmp.c_str());
+    return false;
+  }
+
+  munmap(idx, idx_length);
+  close(idx_fd);
+  idx = grown;
+  idx_fd = fd;
+  idx_length = IndexLength(capacity);
+  return true;
+}
+
+BlockStore::store_entry_t* BlockStore::Probe(const BlockHash &hash) const{
+  return Probe(idx, hash);
+}
+
+BlockStore::store_entry_t* BlockStore::Probe(store_hdr_t *index, const BlockHash &hash){
+  store_entry_t *slots = (store_entry_t*) (index + 1);
+  uint64_t mask = index->capacity - 1;
+  uint64_t pos = hash.Hash() & mask;
+  while (slots[pos].used && memcmp(slots[pos].hash, hash.data(), Block::HASH_SIZE) != 0)
+    pos = (pos + 1) & mask;
+  return &slots[pos];
+}
+
+void BlockStore::Cache(const BlockHash &hash, shared_ptr<const Block> block){
+  if (cacheCapacity == 0)
+    return;
+  lru.push_front(make_pair(hash, block));
+  cache[hash] = lru.begin();
+  if (lru.size() > cacheCapacity){
+    cache.erase(lru.back().first);
+    lru.pop_back();
+  }
+}
+
+void BlockStore::Close(){
+  if (idx != nullptr)
+    munmap(idx, idx_length);
+  if (log_fd >= 0)
+    close(log_fd);
+  if (idx_fd >= 0)
+    close(idx_fd);
+  idx = nullptr;
+  idx_length = 0;
+  log_fd = -1;
+  idx_fd = -1;
+  log_size = 0;
+  lru.clear();
+  cache.clear();
+}
@@ -0,0 +1,93 @@
+#ifndef BLOCK_STORE_H
+#define BLOCK_STORE_H
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "block.h"
+
+using namespace std;
+
+/**
+ * Append-only on-disk storage of blocks.
+ *
+ * Blocks are appended serialized to a log file (<path>.log) and located
+ * through an open-addressing hash -> offset table kept in an mmap'd file
+ * (<path>.idx). A bounded LRU cache of deserialized blocks sits in front of
+ * the log. Blocks are never removed, and a store can be reopened by a
+ * later run.
+ */
+class BlockStore{
+
+  public:
+    typedef struct store_hdr_t{
+      char      magic[8];
+      uint64_t  capacity;   // number of slots, a power of 2
+      uint64_t  count;      // number of used slots
+    } store_hdr_t;
+
+    typedef struct store_entry_t{
+      char      hash[Block::HASH_SIZE];
+      uint64_t  offset;     // offset of the serialized block in the log
+      uint32_t  length;     // length of the serialized block
+      uint32_t  used;
+    } store_entry_t;
+
+  public:
+    /**
+     * cacheCapacity is the number of deserialized blocks kept in memory
+     */
+    BlockStore(size_t cacheCapacity = 1024);
+    BlockStore(const BlockStore &s) = delete;
+    BlockStore& operator=(const BlockStore &s) = delete;
+    ~BlockStore();
+
+  public:
+    /**
+     * Open or create the store files at path. Return false on IO error.
+     */
+    bool Open(string path);
+
+    /**
+     * Append the block to the log if it is not already stored, and keep
+     * it in the cache without copying it.
+     * Return false on IO error.
+     */
+    bool Put(shared_ptr<const Block> block);
+
+    bool Contains(const BlockHash &hash) const;
+
+    /**
+     * Return the block with the given hash, reading it from the log on a
+     * cache miss, or nullptr if it is not stored or cannot be read.
+     */
+    shared_ptr<const Block> Get(const BlockHash &hash);
+
+    size_t GetBlocksCount() const;
+    size_t GetCacheSize() const;
+
+  private:
+    static size_t IndexLength(uint64_t capacity);
+    static store_hdr_t* MapIndex(int fd, uint64_t capacity);
+    bool GrowIndex();
+    store_entry_t* Probe(const BlockHash &hash) const;
+    static store_entry_t* Probe(store_hdr_t *index, const BlockHash &hash);
+    void Cache(const BlockHash &hash, shared_ptr<const Block> block);
+    void Close();
+
+  private:
+    string                   path;
+    int                      log_fd;
+    uint64_t                 log_size;
+    int                      idx_fd;
+    store_hdr_t*             idx;        // mmap'd index file
+    size_t                   idx_length;
+
+    // LRU cache, most recently used first
+    size_t                   cacheCapacity;
+    list<pair<BlockHash, shared_ptr<const Block>>> lru;
+    unordered_map<BlockHash, list<pair<BlockHash, shared_ptr<const Block>>>::iterator> cache;
+};
+
+#endif
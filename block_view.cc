@@ -0,0 +1,179 @@
+#include "block_view.h"
+
+TransactionView::TransactionView(){
+  data = nullptr;
+  length = 0;
+  memset(&header, 0, sizeof(header));
+}
+
+TransactionView::TransactionView(const char *data, size_t length){
+  this->data = data;
+  this->length = length;
+  memset(&header, 0, sizeof(header));
+  if (length >= sizeof(header))
+    memcpy(&header, data, sizeof(header));
+}
+
+bool TransactionView::IsValid() const{
+  return data != nullptr && length >= sizeof(header) &&
+    header.size >= (int) sizeof(header) && (size_t) header.size <= length;
+}
+
+string TransactionView::GetHash() const{
+  return string(header.hash, Transaction::HASH_SIZE);
+}
+
+TxHash TransactionView::GetTxHash() const{
+  return TxHash(header.hash);
+}
+
+int TransactionView::GetSize() const{
+  return header.size;
+}
+
+double TransactionView::GetTimestamp() const{
+  return header.timestamp;
+}
+
+string_view TransactionView::GetPayload() const{
+  return string_view(data + sizeof(header), header.size - sizeof(header));
+}
+
+string_view TransactionView::GetBytes() const{
+  return string_view(data, header.size);
+}
+
+Transaction TransactionView::ToTransaction() const{
+  return Transaction(header, string(GetPayload()));
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+BlockView::BlockView(){
+  data = nullptr;
+  length = 0;
+  memset(&header, 0, sizeof(header));
+}
+
+BlockView::BlockView(const char *data, size_t length){
+  this->data = data;
+  this->length = length;
+  memset(&header, 0, sizeof(header));
+  if (length >= sizeof(header))
+    memcpy(&header, data, sizeof(header));
+}
+
+BlockView::BlockView(const string &serie) : BlockView(serie.data(), serie.size()){
+}
+
+bool BlockView::IsValid() const{
+  if (data == nullptr || length < sizeof(header))
+    return false;
+  if (header.parents_count < 0 || header.tx_count < 0)
+    return false;
+  // The size of a block never exceeds its serialization
+  if (header.size < 0 || (size_t) header.size > length)
+    return false;
+
+  size_t tables = (size_t) header.parents_count * Block::HASH_SIZE +
+    (size_t) header.tx_count * sizeof(uint32_t);
+  if (sizeof(header) + tables > length)
+    return false;
+
+  // Transactions are contiguous, so each offset must be where the
+  // previous transaction ends
+  size_t end = sizeof(header) + tables;
+  for (int i = 0; i < header.tx_count; ++i){
+    if (TxOffset(i) != end)
+      return false;
+    TransactionView t(data + end, length - end);
+    if (!t.IsValid())
+      return false;
+    end += t.GetSize();
+  }
+  return true;
+}
+
+string BlockView::GetHash() const{
+  return string(header.hash, Block::HASH_SIZE);
+}
+
+BlockHash BlockView::GetBlockHash() const{
+  return BlockHash(header.hash);
+}
+
+int BlockView::GetIndex() const{
+  return header.index;
+}
+
+int BlockView::GetLeader() const{
+  return header.leader;
+}
+
+int BlockView::GetBlockType() const{
+  return header.blockType;
+}
+
+string BlockView::GetGroupId() const{
+  return string(header.groupId, Block::HASH_SIZE);
+}
+
+double BlockView::GetTimestamp() const{
+  return header.timestamp;
+}
+
+int BlockView::GetSize() const{
+  return header.size;
+}
+
+string BlockView::GetMerkleRoot() const{
+  return string(header.merkleRoot, Block::HASH_SIZE);
+}
+
+int BlockView::GetParentsCount() const{
+  return header.parents_count;
+}
+
+string BlockView::GetParent(int i) const{
+  return string(ParentsBegin() + i * Block::HASH_SIZE, Block::HASH_SIZE);
+}
+
+BlockHash BlockView::GetParentHash(int i) const{
+  return BlockHash(ParentsBegin() + i * Block::HASH_SIZE);
+}
+
+int BlockView::GetTxsCount() const{
+  return header.tx_count;
+}
+
+TransactionView BlockView::GetTransaction(int i) const{
+  uint32_t begin = TxOffset(i);
+  uint32_t end = (i + 1 < header.tx_count) ? TxOffset(i + 1) : length;
+  return TransactionView(data + begin, end - begin);
+}
+
+Block BlockView::ToBlock() const{
+  vector<string> parents;
+  parents.reserve(header.parents_count);
+  for (int i = 0; i < header.parents_count; ++i)
+    parents.push_back(GetParent(i));
+
+  vector<Transaction> transactions;
+  transactions.reserve(header.tx_count);
+  for (int i = 0; i < header.tx_count; ++i)
+    transactions.push_back(GetTransaction(i).ToTransaction());
+
+  return Block(GetHash(), header.index, header.leader, header.blockType,
+               GetGroupId(), move(parents), header.timestamp, move(transactions));
+}
+
+const char* BlockView::ParentsBegin() const{
+  return data + sizeof(header);
+}
+
+uint32_t BlockView::TxOffset(int i) const{
+  uint32_t offset;
+  memcpy(&offset, ParentsBegin() + header.parents_count * Block::HASH_SIZE +
+         i * sizeof(uint32_t), sizeof(offset));
+  return offset;
+}
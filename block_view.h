@@ -0,0 +1,107 @@
+#ifndef BLOCK_VIEW_H
+#define BLOCK_VIEW_H
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include "block.h"
+#include "transaction.h"
+
+using namespace std;
+
+/**
+ * Read-only view of a serialized transaction.
+ * Nothing is copied: the view points into the buffer given to the
+ * constructor, which must outlive it.
+ */
+class TransactionView{
+
+  public:
+    TransactionView();
+    TransactionView(const char *data, size_t length);
+
+  public:
+    /**
+     * Checks that the buffer holds a whole transaction
+     */
+    bool IsValid () const;
+
+    string GetHash () const;
+    TxHash GetTxHash () const;
+    int GetSize () const;
+    double GetTimestamp () const;
+    string_view GetPayload () const;
+
+    /**
+     * Return the serialized bytes of the transaction
+     */
+    string_view GetBytes () const;
+
+    /**
+     * Build a Transaction from the view. Copies the payload once.
+     */
+    Transaction ToTransaction () const;
+
+  private:
+    const char*              data;
+    size_t                   length;
+    Transaction::tx_t        header;
+};
+
+/**
+ * Read-only view of a serialized block.
+ * The header and the transaction offset table are parsed in place, so
+ * parents and transactions can be reached directly without materializing
+ * the block. The buffer must outlive the view.
+ */
+class BlockView{
+
+  public:
+    BlockView();
+    BlockView(const char *data, size_t length);
+    BlockView(const string &serie);
+
+  public:
+    /**
+     * Checks that the header, parents and offset table fit in the buffer and
+     * that every transaction offset points inside it
+     */
+    bool IsValid () const;
+
+    string GetHash () const;
+    BlockHash GetBlockHash () const;
+    int GetIndex () const;
+    int GetLeader () const;
+    int GetBlockType () const;
+    string GetGroupId () const;
+    double GetTimestamp () const;
+    int GetSize () const;
+    string GetMerkleRoot () const;
+
+    int GetParentsCount () const;
+    string GetParent (int i) const;
+    BlockHash GetParentHash (int i) const;
+
+    int GetTxsCount () const;
+    /**
+     * Return a view of the i-th transaction through the offset table.
+     * Should be called on a valid view.
+     */
+    TransactionView GetTransaction (int i) const;
+
+    /**
+     * Build a Block from the view. Copies each transaction once.
+     */
+    Block ToBlock () const;
+
+  private:
+    const char* ParentsBegin () const;
+    uint32_t TxOffset (int i) const;
+
+  private:
+    const char*              data;
+    size_t                   length;
+    Block::block_t           header;
+};
+
+#endif
@@ -1,16 +1,64 @@
 #include "blockgraph.h"
+#include "blockgraph_snapshot.h"
+#include "block_store.h"
+#include "b4m_traces.h"
 
 Blockgraph::Blockgraph ()
 {
-  txsCount = 0;
-  txsSize = 0;
+  data = make_shared<Data>();
+  data->byteSize = 0;
+  data->txsCount = 0;
+  data->txsSize = 0;
+  traces = nullptr;
 
-  Block genesisBlock("0", 0, 0, 0, "0", vector<string> (), 0.0, vector<Transaction> ());  // new
-  AddBlock(genesisBlock);
+  AddBlock(make_shared<const Block>("0", 0, 0, 0, "0", vector<string> (), 0.0, vector<Transaction> ()));  // new
 }
 
 Blockgraph::Blockgraph (const Blockgraph &b){
-  blocks = b.blocks;
+  data = b.data;
+  traces = nullptr;
+}
+
+Blockgraph::Blockgraph (char* blockgraph_serialized) :
+  Blockgraph(blockgraph_serialized, BlockgraphSnapshot::GetSize(blockgraph_serialized)){
+}
+
+Blockgraph::Blockgraph (const char* blockgraph_serialized, size_t length) : Blockgraph(){
+  if (blockgraph_serialized == nullptr || !BlockgraphSnapshot(blockgraph_serialized, length).IsValid()){
+    std::cout << "ERROR : INVALID BLOCKGRAPH SNAPSHOT" << std::endl;
+    return;
+  }
+  Load(make_shared<const BlockgraphSnapshot>(string(blockgraph_serialized, length)));
+}
+
+Blockgraph::Blockgraph (shared_ptr<const BlockgraphSnapshot> snapshot) : Blockgraph(){
+  Load(snapshot);
+}
+
+void Blockgraph::Load (shared_ptr<const BlockgraphSnapshot> snapshot){
+  if (snapshot == nullptr || !snapshot->IsValid()){
+    std::cout << "ERROR : INVALID BLOCKGRAPH SNAPSHOT" << std::endl;
+    return;
+  }
+
+  Data &d = Detach();
+  d.snapshot = snapshot;
+  int count = snapshot->GetBlocksCount();
+  d.blocks.Reserve(d.blocks.Size() + count);
+  d.headers.Reserve(d.blocks.Size() + count);
+  for (int i = 0; i < count; ++i){
+    BlockHash key(snapshot->GetEntry(i).hash);
+    BlockView view = snapshot->GetBlockView(i);
+    if (!view.IsValid() || view.GetBlockHash() != key){
+      std::cout << "ERROR : INVALID BLOCK " << i << " IN BLOCKGRAPH SNAPSHOT" << std::endl;
+      continue;
+    }
+    // The genesis block is in the snapshot too
+    if (d.blocks.Contains(key))
+      continue;
+    d.blocks.Insert(key, nullptr);
+    Index(d, key, view);
+  }
 }
 
 Blockgraph::~Blockgraph (void)
@@ -19,193 +67,355 @@ Blockgraph::~Blockgraph (void)
 
 int Blockgraph::GetByteSize () {
 
-  int size=0;
-  for (auto& b : blocks){
-    size += b.second.GetSize();
-  }
-  return size;
+  return data->byteSize;
 
 }
 
 int Blockgraph::GetTxsCount(){
-  return txsCount;
+  return data->txsCount;
 }
 
 
 int Blockgraph::GetTxsByteSize (){
-  return txsSize;
+  return data->txsSize;
 }
 
 int Blockgraph::GetBlocksCount () const{
-  return blocks.size();
+  return data->blocks.Size();
 }
 
-string Blockgraph::GetGroupId(string hash){
-  string ret = "";
-  for (auto &b : blocks){
-    if (b.second.GetHash() == hash){
-      ret = b.second.GetGroupId();
-      return ret;
-    }
-  }
-  return ret = "0000";
+int Blockgraph::GetBlocksCountInGroup (const string &groupId) const{
+  auto it = data->groupCounts.find(BlockHash(groupId));
+  if (it == data->groupCounts.end())
+    return 0;
+  return it->second;
+}
+
+const vector<int>& Blockgraph::GetTxsPerBlockHistogram () const{
+  return data->txsPerBlock;
+}
+
+string Blockgraph::GetGroupId(const string &hash) const{
+  shared_ptr<const Block> b = GetSharedBlock(hash);
+  if (b == nullptr)
+    return "0000";
+  return b->GetGroupId();
 }
 
 vector<string> Blockgraph::GetAllBlockHashes () const{
   vector<string> ret = vector<string>();
-  for (auto &b : blocks){
-    ret.push_back(b.second.GetHash());
+  for (auto &b : data->blocks){
+    ret.push_back(b.first.ToString());
   }
   return ret;
 }
 
-const map<string, Block>& Blockgraph::GetBlocks () const{
-  return blocks;
+const FlatHashMap<BlockHash, shared_ptr<const Block>>& Blockgraph::GetBlocks () const{
+  return data->blocks;
+}
+
+const HeaderTable& Blockgraph::GetHeaderTable () const{
+  return data->headers;
+}
+
+vector<string> Blockgraph::GetBlocksMatching (const HeaderTable::filter_t &filter) const{
+  vector<uint32_t> rows;
+  data->headers.Scan(filter, rows);
+
+  vector<string> ret;
+  ret.reserve(rows.size());
+  auto blocks = data->blocks.begin();
+  for (uint32_t r : rows)
+    ret.push_back(blocks[r].first.ToString());
+  return ret;
+}
+
+string Blockgraph::Serialize () const{
+  return BlockgraphSnapshot::Write(*this);
 }
 
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-void Blockgraph::AddBlock  (Block& newBlock){
+void Blockgraph::AddBlock  (const Block& newBlock){
     bool present = HasBlock(newBlock);
     if (!present){
-      txsCount += newBlock.GetTxsCount();
-      txsSize += newBlock.CalculeTxsSize();
-      blocks.insert({newBlock.GetHash(), newBlock});
+      AddBlock(make_shared<const Block>(newBlock));
+    }
+}
+
+void Blockgraph::AddBlock  (shared_ptr<const Block> newBlock){
+    BlockHash key(newBlock->GetHash());
+    bool present = data->blocks.Contains(key);
+    if (!present){
+      Insert(Detach(), key, newBlock);
     }
     // If block already present in Blockgraph -> reject the block
 }
 
-bool Blockgraph::HasBlock (Block& block) {
-  return (blocks.count(block.GetHash()) == 1);
+Blockgraph::merge_t Blockgraph::Merge (const Blockgraph &other){
+  merge_t ret;
+  if (data != other.data){
+    Data &d = Detach();
+    d.blocks.Reserve(d.blocks.Size() + other.data->blocks.Size());
+    d.headers.Reserve(d.blocks.Size() + other.data->blocks.Size());
+
+    // Duplicates are checked against the blockgraph before the merge, a
+    // transaction repeated only within the received blocks is not one
+    vector<pair<BlockHash, shared_ptr<const Block>>> received;
+    set<TxHash> duplicated;
+    for (auto &b : other.data->blocks){
+      if (d.blocks.Contains(b.first))
+        continue;
+      shared_ptr<const Block> block = other.GetSharedBlock(b.first);
+      if (block == nullptr)
+        continue;
+      for (auto &t : block->GetTransactions()){
+        TxHash tx(t.GetHash());
+        if (d.txIndex.count(tx) && duplicated.insert(tx).second)
+          ret.duplicatedTxs.push_back(t.GetHash());
+      }
+      received.push_back({b.first, block});
+    }
+    for (auto &b : received)
+      Insert(d, b.first, b.second);
+  }
+  ret.tips = GetChildlessBlockList();
+  return ret;
+}
+
+void Blockgraph::Insert (Data &d, const BlockHash &key, shared_ptr<const Block> newBlock){
+  // The block stays in memory if the store fails to write it
+  if (d.store && d.store->Put(newBlock)){
+    d.blocks.Insert(key, nullptr);
+  } else {
+    d.blocks.Insert(key, newBlock);
+  }
+  if (Index(d, key, *newBlock) && traces != nullptr)
+    traces->DuplicatedTxs(make_pair((float) newBlock->GetTimestamp(),
+                                    (int) d.duplicates.GetLastJoin().duplicatedTxs.size()));
+}
+
+// Accessors common to Block and BlockView, for Index
+static int ParentsCount (const Block &b){ return b.GetParents().size(); }
+static int ParentsCount (const BlockView &b){ return b.GetParentsCount(); }
+static BlockHash ParentHash (const Block &b, int i){ return BlockHash(b.GetParents()[i]); }
+static BlockHash ParentHash (const BlockView &b, int i){ return b.GetParentHash(i); }
+static TxHash TxHashAt (const Block &b, int i){ return TxHash(b.GetTransaction(i).GetHash()); }
+static TxHash TxHashAt (const BlockView &b, int i){ return b.GetTransaction(i).GetTxHash(); }
+static int TxSizeAt (const Block &b, int i){ return b.GetTransaction(i).GetSize(); }
+static int TxSizeAt (const BlockView &b, int i){ return b.GetTransaction(i).GetSize(); }
+
+template<typename B>
+bool Blockgraph::Index (Data &d, const BlockHash &key, const B &block){
+  BlockHash groupId(block.GetGroupId());
+  int txsCount = block.GetTxsCount();
+  d.byteSize += block.GetSize();
+  d.txsCount += txsCount;
+  d.groupCounts[groupId]++;
+  if ((int) d.txsPerBlock.size() <= txsCount)
+    d.txsPerBlock.resize(txsCount + 1, 0);
+  d.txsPerBlock[txsCount]++;
+  // Parents may not be in the blockgraph yet, the index is keyed by hash only
+  for (int i = 0; i < ParentsCount(block); ++i){
+    BlockHash parent = ParentHash(block, i);
+    d.children[parent].push_back(key);
+    d.childless.erase(parent);
+  }
+  // A block received after its children is not a tip
+  if (d.children.count(key) == 0)
+    d.childless.insert(key);
+  for (int i = 0; i < txsCount; ++i){
+    d.txsSize += TxSizeAt(block, i);
+    d.txIndex[TxHashAt(block, i)].push_back(key);
+  }
+  d.groupIndex.insert({{groupId, block.GetIndex()}, key});
+  d.heightIndex.insert({block.GetIndex(), key});
+  d.timeIndex.insert({block.GetTimestamp(), key});
+  d.headers.Add(block);
+  return d.duplicates.AddBlock(block);
 }
 
-bool Blockgraph::HasBlock (string hash) {
-  return (blocks.count(hash) == 1);
+bool Blockgraph::HasBlock (const Block& block) const{
+  return data->blocks.Contains(BlockHash(block.GetHash()));
 }
 
-Block Blockgraph::GetBlock (string hash) {
-  if (HasBlock(hash))
-    return blocks[hash];
+bool Blockgraph::HasBlock (const string &hash) const{
+  return data->blocks.Contains(BlockHash(hash));
+}
+
+Block Blockgraph::GetBlock (const string &hash) const{
+  shared_ptr<const Block> b = GetSharedBlock(hash);
+  if (b != nullptr)
+    return *b;
   return Block("-1", -1, -1, -1, "-1", vector<string> (), -1.0, vector<Transaction> ());  // new
 }
 
-vector<string> Blockgraph::GetChildren (Block &block){
+shared_ptr<const Block> Blockgraph::GetSharedBlock (const string &hash) const{
+  return GetSharedBlock(BlockHash(hash));
+}
 
-  vector <string> children = vector<string> ();
+shared_ptr<const Block> Blockgraph::GetSharedBlock (const BlockHash &hash) const{
+  const shared_ptr<const Block> *b = data->blocks.Find(hash);
+  if (b == nullptr)
+    return nullptr;
+  if (*b != nullptr)
+    return *b;
+  // Blocks loaded from a snapshot are read from it, the others are in the store
+  int i = data->snapshot ? data->snapshot->Find(hash.ToString()) : -1;
+  if (i >= 0){
+    BlockView view = data->snapshot->GetBlockView(i);
+    if (view.IsValid())
+      return make_shared<const Block>(view.ToBlock());
+    std::cout << "ERROR : CANNOT READ BLOCK " << dump(hash.data(), 10) << " FROM THE SNAPSHOT" << std::endl;
+    return nullptr;
+  }
+  if (data->store){
+    shared_ptr<const Block> stored = data->store->Get(hash);
+    if (stored == nullptr)
+      std::cout << "ERROR : CANNOT READ BLOCK " << dump(hash.data(), 10) << " FROM THE STORE" << std::endl;
+    return stored;
+  }
+  return nullptr;
+}
 
-  for (auto& b : blocks){
-    if (block.IsChild(b.second))
-      children.push_back(b.first);
+void Blockgraph::SetBlockStore (shared_ptr<BlockStore> store){
+  Data &d = Detach();
+  d.store = store;
+  for (auto &b : d.blocks){
+    if (b.second != nullptr && store->Put(b.second))
+      b.second = nullptr;
   }
-  return children;
+}
+
+vector<string> Blockgraph::GetChildren (const Block &block) const{
+
+  auto it = data->children.find(BlockHash(block.GetHash()));
+  if (it == data->children.end())
+    return vector<string> ();
+  return ToStrings(it->second);
 }
 
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-vector<Block> Blockgraph::GetBlocksFromGroup (string groupId) {
+vector<Block> Blockgraph::GetBlocksFromGroup (const string &groupId) const{
 
   vector<Block> blocks_group = vector<Block> ();
 
-  for(auto& b : blocks){
-    if (b.second.GetGroupId() == groupId){
-      blocks_group.push_back(b.second);
-    }
+  for (auto &h : GetGroupBlocksBetween(groupId, numeric_limits<int>::min(),
+                                       numeric_limits<int>::max())){
+    shared_ptr<const Block> block = GetSharedBlock(h);
+    if (block != nullptr)
+      blocks_group.push_back(*block);
   }
   return blocks_group;
 }
 
+vector<string> Blockgraph::GetGroupBlocksBetween (const string &groupId, int minIndex, int maxIndex) const{
+
+  vector<string> ret = vector<string> ();
+  if (minIndex > maxIndex)
+    return ret;
+
+  BlockHash group(groupId);
+  auto first = data->groupIndex.lower_bound({group, minIndex});
+  auto last = data->groupIndex.upper_bound({group, maxIndex});
+  for (auto it = first; it != last; ++it)
+    ret.push_back(it->second.ToString());
+  return ret;
+}
+
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-vector<Block> Blockgraph::GetChildlessBlocks (){
+vector<string> Blockgraph::GetBlocksBetweenHeights (int minIndex, int maxIndex){
 
-  set<string> childless;
-  vector<Block> chless;
+  vector<string> ret = vector<string> ();
+  if (minIndex > maxIndex)
+    return ret;
 
-  // Initialisation
-  for (auto& b : blocks)
-    childless.insert(b.first);
+  auto first = data->heightIndex.lower_bound(minIndex);
+  auto last = data->heightIndex.upper_bound(maxIndex);
+  for (auto it = first; it != last; ++it)
+    ret.push_back(it->second.ToString());
+  return ret;
+}
 
-  for (auto& b : blocks){
-    for (auto& p : b.second.GetParents())
-        childless.erase(p);
-  }
+vector<string> Blockgraph::GetBlocksCreatedBetween (double from, double to){
 
-  for (auto &e : childless){
-    chless.push_back(GetBlock(e));
-  }
+  vector<string> ret = vector<string> ();
+  if (from >= to)
+    return ret;
 
-  return chless;
-  //return vector<string>(childless.begin(), childless.end());
+  auto first = data->timeIndex.lower_bound(from);
+  auto last = data->timeIndex.lower_bound(to);
+  for (auto it = first; it != last; ++it)
+    ret.push_back(it->second.ToString());
+  return ret;
 }
 
-vector<string> Blockgraph::GetChildlessBlockList (){
-  vector<string> ret = vector<string> ();
-  set<string> childless;
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-  for (auto& b : blocks)
-    childless.insert(b.first);
+vector<Block> Blockgraph::GetChildlessBlocks (){
 
-  for (auto& b : blocks){
-    for (auto& p : b.second.GetParents())
-        childless.erase(p);
-  }
+  vector<Block> chless;
 
-  for (auto &e : childless){
-    ret.push_back(e);
+  for (auto &e : data->childless){
+    shared_ptr<const Block> block = GetSharedBlock(e);
+    if (block != nullptr)
+      chless.push_back(*block);
   }
 
-return ret;
+  return chless;
+}
+
+vector<string> Blockgraph::GetChildlessBlockList (){
+  vector<string> ret;
+  ret.reserve(data->childless.size());
+  for (auto &h : data->childless)
+    ret.push_back(h.ToString());
+  return ret;
+}
+
+const set<BlockHash>& Blockgraph::GetTips () const{
+  return data->childless;
 }
 
 
-bool Blockgraph::IsChildless(Block &block){
+bool Blockgraph::IsChildless(const Block &block) const{
+  return (data->children.count(BlockHash(block.GetHash())) == 0);
+}
 
-  for (auto& b : blocks){
-    for (auto& p : b.second.GetParents()){
-      if (p == block.GetHash()){
-        return false;
-      }
-    }
-  }
-  return true;
+bool Blockgraph::IsTxInBG(const Transaction &t){
+  return (data->txIndex.count(TxHash(t.GetHash())) == 1);
 }
 
-bool Blockgraph::IsTxInBG(Transaction &t){
-  for (auto& b : blocks){
-    for (auto& tx : b.second.GetTransactions()){
-      if (tx.GetHash() == t.GetHash()){
-        return true;
-      }
-    }
-  }
-  return false;
+vector<string> Blockgraph::GetBlocksWithTx(const string &txHash) const{
+  auto it = data->txIndex.find(TxHash(txHash));
+  if (it == data->txIndex.end())
+    return vector<string> ();
+  return ToStrings(it->second);
 }
 
-int Blockgraph::CountRepTxInBlockGraph(Transaction &t){
-  int count = 0;
-  for (auto& b : blocks){
-    for (auto& tx : b.second.GetTransactions()){
-      if (tx.GetHash() == t.GetHash()){
-        count++;
-      }
-    }
-  }
-  return count;
+int Blockgraph::CountRepTxInBlockGraph(const Transaction &t){
+  auto it = data->txIndex.find(TxHash(t.GetHash()));
+  if (it == data->txIndex.end())
+    return 0;
+  return it->second.size();
 }
 
 int Blockgraph::ComputeTransactionRepetition (){
-  map<string, int> mem;
+  set<string> mem;
   int count = 0;
-  for (auto& b : blocks){
-    for (auto& tx : b.second.GetTransactions()){
+  // Walk the blocks rather than the index to keep the report in insertion order
+  for (auto& b : data->blocks){
+    // Keep the block alive while iterating, it may come from the store
+    shared_ptr<const Block> block = GetSharedBlock(b.first);
+    if (block == nullptr)
+      continue;
+    for (auto& tx : block->GetTransactions()){
       int res = CountRepTxInBlockGraph(tx);
-      if (res > 1){
-        auto it = mem.find(tx.GetHash());
-        if (it == mem.end()){
-          std::cout << "Transaction Hash: " << stoi(tx.GetHash()) << " : Ocurrences : " << res << endl;
-          count ++;
-          mem[tx.GetHash()] = res;
-        }
+      if (res > 1 && mem.insert(tx.GetHash()).second){
+        std::cout << "Transaction Hash: " << stoi(tx.GetHash()) << " : Ocurrences : " << res << endl;
+        count ++;
       }
     }
   }
@@ -213,11 +423,7 @@ int Blockgraph::ComputeTransactionRepetition (){
 }
 
 float Blockgraph::MeanTxPerBlock(){
-  int txsInBlock = 0;
-  for (auto& b : blocks){
-    txsInBlock += b.second.GetTransactions().size();
-  }
-  float mean = txsInBlock/GetBlocksCount();
+  float mean = (float) data->txsCount / GetBlocksCount();
   return mean;
 }
 
@@ -225,15 +431,40 @@ ostream& operator<< (std::ostream &out, const Blockgraph &bg){
 
   out << "Blockgraph (" << bg.GetBlocksCount() << ",";
   out << "[";
-  for (auto b : bg.GetBlocks())
-    out << b.second << ",";
+  for (auto &b : bg.GetBlocks()){
+    shared_ptr<const Block> block = bg.GetSharedBlock(b.first);
+    if (block != nullptr)
+      out << *block << ",";
+  }
   out << "])";
 
   return out;
 }
 
+const DuplicateTxDetector& Blockgraph::GetDuplicateTxDetector () const{
+  return data->duplicates;
+}
+
+void Blockgraph::SetTraces (B4MTraces *traces){
+  this->traces = traces;
+}
+
 Blockgraph& Blockgraph::operator=(const Blockgraph &bg){
-  blocks = bg.blocks;
+  data = bg.data;
 
   return *this;
 }
+
+vector<string> Blockgraph::ToStrings (const vector<BlockHash> &hashes){
+  vector<string> ret;
+  ret.reserve(hashes.size());
+  for (auto &h : hashes)
+    ret.push_back(h.ToString());
+  return ret;
+}
+
+Blockgraph::Data& Blockgraph::Detach (){
+  if (data.use_count() > 1)
+    data = make_shared<Data>(*data);
+  return *data;
+}
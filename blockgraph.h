@@ -6,17 +6,50 @@
 #define BLOCKGRAPH_H
 #include <vector>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <limits>
+#include <memory>
 #include "block.h"
 #include "transaction.h"
+#include "flat_hash_map.h"
+#include "header_table.h"
+#include "duplicate_tx_detector.h"
 
 using namespace std;
 
+class BlockStore;
+class BlockgraphSnapshot;
+class B4MTraces;
+
 class Blockgraph
 {
+public:
+  // Typedef
+  typedef struct merge_t{
+    vector<string>      tips;  // tips of the blockgraph after the merge
+    vector<string>      duplicatedTxs;  // hashes of the transactions of the merged blocks already in the blockgraph
+  } merge_t;
+
 public:
   Blockgraph ();
   Blockgraph (const Blockgraph& b);
+  /**
+   * Rebuild a blockgraph from a snapshot made by Serialize()
+   * (see BlockgraphSnapshot). An invalid snapshot gives a blockgraph with
+   * only the genesis block.
+   * The first constructor takes the snapshot length from its header once
+   * the magic and the version have been checked. Prefer the second one,
+   * which checks the snapshot against the length of the buffer. Both copy
+   * the buffer, use the third one with a snapshot opened by
+   * BlockgraphSnapshot::Open to map a file instead.
+   * Only the block headers, the parents and the transaction headers are
+   * read to build the indexes. Blocks stay in the snapshot and are read
+   * by GetSharedBlock.
+   */
   Blockgraph (char* blockgraph_serialized);
+  Blockgraph (const char* blockgraph_serialized, size_t length);
+  Blockgraph (shared_ptr<const BlockgraphSnapshot> snapshot);
   virtual ~Blockgraph();
 
 public:
@@ -37,41 +70,97 @@ public:
    *  Get total number of blocks
    */
   int GetBlocksCount () const;
+  /**
+   *  Get the number of blocks of the group given, as returned by
+   *  Block::GetGroupId
+   */
+  int GetBlocksCountInGroup (const string &groupId) const;
+  /**
+   *  Get the number of blocks per number of transactions: element n is the
+   *  number of blocks holding n transactions
+   */
+  const vector<int>& GetTxsPerBlockHistogram () const;
   /**
    *  Get all the hashes in the blockgraph
    */
   vector<string> GetAllBlockHashes () const;
   /**
-   *  Get all the blocks in the Blockgraph
+   *  Get all the blocks in the Blockgraph.
+   *  The reference is valid until the next AddBlock. Blocks kept in a
+   *  block store or in a snapshot are null here, use GetSharedBlock to
+   *  load them.
+   */
+  const FlatHashMap<BlockHash, shared_ptr<const Block>>& GetBlocks () const;
+  /**
+   *  Get the columnar table of the block headers. Row i is the i-th
+   *  block of GetBlocks(). The reference is valid until the next AddBlock.
+   */
+  const HeaderTable& GetHeaderTable () const;
+  /**
+   *  Get the hashes of the blocks matching filter, in insertion order
+   */
+  vector<string> GetBlocksMatching (const HeaderTable::filter_t &filter) const;
+  /**
+   *  Serialize the whole blockgraph into a snapshot
    */
-  const map<string, Block>& GetBlocks () const;
+  string Serialize () const;
 
 public:
   // functions related with blocks
   /**
-   * Adds a new block in the blockgraph if this block is valid
+   * Adds a new block in the blockgraph if this block is valid.
+   * The block is copied, so it is not shared with the caller: a caller
+   * already holding the block in a shared_ptr should use the overload
+   * below.
    */
-   void AddBlock (Block& newBlock);
+   void AddBlock (const Block& newBlock);
+   /**
+    * Adds a block without copying it. The block is shared with every
+    * other blockgraph holding it.
+    */
+   void AddBlock (shared_ptr<const Block> newBlock);
+   /**
+    * Adds the blocks of other missing from this blockgraph, in the order
+    * other received them. Blocks are shared, not copied.
+    * Returns the resulting tips, which the merge block should reference,
+    * and the transactions both sides included.
+    */
+   merge_t Merge (const Blockgraph &other);
    /**
     * Check if the block given has been included in the blockgraph.
     */
-   bool HasBlock (Block &block);
+   bool HasBlock (const Block &block) const;
    /**
     * Checks if the block with the given hash
     * has been included in the blockgraph
     */
-   bool HasBlock (string hash);
+   bool HasBlock (const string &hash) const;
    /**
     * Return the block with the specified hash.
     * Should be called after hasBlock() to make sure that the block exists.
     */
-   Block GetBlock (string hash);
+   Block GetBlock (const string &hash) const;
+   /**
+    * Return the shared block with the specified hash, or nullptr if
+    * the block is not in the blockgraph or cannot be read from the block
+    * store or the snapshot. Callers skip the blocks they cannot read.
+    * Blocks read from a snapshot are built again on each call.
+    */
+   shared_ptr<const Block> GetSharedBlock (const string &hash) const;
+   shared_ptr<const Block> GetSharedBlock (const BlockHash &hash) const;
+   /**
+    * Keep the blocks in the given store instead of in memory. Blocks
+    * already in the blockgraph are moved to the store. Blocks the store
+    * fails to write are kept in memory. Copies of this blockgraph share
+    * the store.
+    */
+   void SetBlockStore (shared_ptr<BlockStore> store);
    /**
     * Gets the children of a block
     */
-   vector<string> GetChildren (Block &block);
+   vector<string> GetChildren (const Block &block) const;
 
-   string GetGroupId(string hash);
+   string GetGroupId(const string &hash) const;
 
 
 public:
@@ -79,7 +168,25 @@ public:
    /**
    * Gets the blocks from the groupId given
    */
-  vector<Block> GetBlocksFromGroup (string groupId);
+  vector<Block> GetBlocksFromGroup (const string &groupId) const;
+  /**
+   * Gets the hashes of the blocks from the groupId given whose height is
+   * between minIndex and maxIndex (both included)
+   */
+  vector<string> GetGroupBlocksBetween (const string &groupId, int minIndex, int maxIndex) const;
+
+
+public:
+  // functions related with blockgraph heights and creation times
+  /**
+   * Gets the hashes of the blocks whose height is between minIndex and
+   * maxIndex (both included)
+   */
+  vector<string> GetBlocksBetweenHeights (int minIndex, int maxIndex);
+  /**
+   * Gets the hashes of the blocks created in [from, to)
+   */
+  vector<string> GetBlocksCreatedBetween (double from, double to);
 
 
 public:
@@ -90,29 +197,102 @@ public:
   //vector<string> GetChildlessBlocks ();
   vector<Block> GetChildlessBlocks();
   vector<string> GetChildlessBlockList ();
+  /**
+   * Gets the hashes of the current top blocks without copying them.
+   * The set is maintained by AddBlock.
+   */
+  const set<BlockHash>& GetTips () const;
 
   /**
    *  Checks if the block given is a childlesblock
    */
-  bool IsChildless (Block &block);
+  bool IsChildless (const Block &block) const;
 
-  bool IsTxInBG (Transaction &t);
+  bool IsTxInBG (const Transaction &t);
+
+  /**
+   * Gets the hashes of the blocks that include the transaction
+   * with the given hash
+   */
+  vector<string> GetBlocksWithTx (const string &txHash) const;
 
 public:
   float MeanTxPerBlock();
 
-  int CountRepTxInBlockGraph (Transaction &t);
+  int CountRepTxInBlockGraph (const Transaction &t);
 
   int ComputeTransactionRepetition ();
 
+  /**
+   * Get the detector of the transactions included by several branches,
+   * fed by AddBlock, Merge and the snapshot loading
+   */
+  const DuplicateTxDetector& GetDuplicateTxDetector () const;
+
+  /**
+   * Report the transactions duplicated across branches to traces, at the
+   * creation time of each block joining branches. Copies of the
+   * blockgraph do not report to them.
+   */
+  void SetTraces (B4MTraces *traces);
+
   friend std::ostream& operator<< (std::ostream &out, const Blockgraph &blockgraph);
   Blockgraph& operator=(const Blockgraph& bg);
 
 private:
-  map<string, Block> blocks;  //vector contening all the blocks
-  int txsCount;
-  int txsSize;
-  vector<int> meanTxBlock;
+  /**
+   * State of the blockgraph. Copies of a blockgraph share it until one of
+   * them adds a block. Blocks are immutable and shared by every state
+   * that holds them, so detaching only copies pointers and indexes.
+   */
+  struct Data{
+    FlatHashMap<BlockHash, shared_ptr<const Block>> blocks;  // all the blocks, in insertion order
+    shared_ptr<BlockStore> store; // if set, blocks are null and kept in the store
+    shared_ptr<const BlockgraphSnapshot> snapshot; // if set, the blocks loaded from it are null
+    int byteSize;
+    int txsCount;
+    int txsSize;
+    unordered_map<BlockHash, int> groupCounts; // groupId -> number of blocks
+    vector<int> txsPerBlock; // number of transactions -> number of blocks
+    unordered_map<BlockHash, vector<BlockHash>> children; // parent hash -> hashes of its children
+    set<BlockHash> childless; // hashes of the blocks no other block references as parent
+    unordered_map<TxHash, vector<BlockHash>> txIndex; // tx hash -> hashes of the blocks including it
+    multimap<pair<BlockHash, int>, BlockHash> groupIndex; // (groupId, height) -> block hash
+    multimap<int, BlockHash> heightIndex; // height -> block hash
+    multimap<double, BlockHash> timeIndex; // creation time -> block hash
+    HeaderTable headers; // block headers, one row per block in insertion order
+    DuplicateTxDetector duplicates; // transactions included by several branches
+  };
+
+  /**
+   * Make sure this blockgraph is the only owner of its state
+   * before modifying it
+   */
+  Data& Detach ();
+
+  /**
+   * Add a block known to be absent, update the indexes and counters and
+   * report the duplicated transactions if it joins branches
+   */
+  void Insert (Data &d, const BlockHash &key, shared_ptr<const Block> newBlock);
+
+  /**
+   * Update the indexes and counters with a block, given as a Block or as
+   * a BlockView. Return true if the block joins branches.
+   */
+  template<typename B>
+  static bool Index (Data &d, const BlockHash &key, const B &block);
+
+  /**
+   * Index the valid blocks of the snapshot without reading their payloads
+   */
+  void Load (shared_ptr<const BlockgraphSnapshot> snapshot);
+
+  static vector<string> ToStrings (const vector<BlockHash> &hashes);
+
+private:
+  shared_ptr<Data> data;
+  B4MTraces* traces;
 
 };
 
@@ -0,0 +1,217 @@
+#include "blockgraph_snapshot.h"
+#include <algorithm>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char SNAPSHOT_MAGIC[8] = {'B', '4', 'M', 'S', 'N', 'A', 'P', 0};
+
+static uint64_t Align8(uint64_t offset){
+  return (offset + 7) & ~(uint64_t)7;
+}
+
+BlockgraphSnapshot::BlockgraphSnapshot(){
+  data = nullptr;
+  length = 0;
+  mapping = nullptr;
+}
+
+BlockgraphSnapshot::BlockgraphSnapshot(const char *data, size_t length){
+  this->data = data;
+  this->length = length;
+  mapping = nullptr;
+}
+
+BlockgraphSnapshot::BlockgraphSnapshot(string serie){
+  owned = move(serie);
+  data = owned.data();
+  length = owned.size();
+  mapping = nullptr;
+}
+
+BlockgraphSnapshot::~BlockgraphSnapshot(){
+  Close();
+}
+
+string BlockgraphSnapshot::Write(const Blockgraph &bg){
+  const auto &blocks = bg.GetBlocks();
+  uint32_t count = blocks.Size();
+
+  snapshot_hdr_t hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+  hdr.version = VERSION;
+  hdr.block_count = count;
+  hdr.table_offset = Align8(sizeof(hdr));
+  hdr.index_offset = Align8(hdr.table_offset + count * sizeof(snapshot_block_t));
+  hdr.payload_offset = Align8(hdr.index_offset + count * sizeof(snapshot_index_t));
+
+  // Lay the payloads out first so that the whole snapshot is allocated once
+  vector<snapshot_block_t> table(count);
+  vector<snapshot_index_t> index(count);
+  uint64_t offset = hdr.payload_offset;
+  uint32_t i = 0;
+  for (auto &b : blocks){
+    shared_ptr<const Block> p = bg.GetSharedBlock(b.first);
+    if (p == nullptr)
+      return string();
+    const Block &block = *p;
+    snapshot_block_t &e = table[i];
+    memset(&e, 0, sizeof(e));
+    e.offset = offset;
+    e.length = block.SerializedSize();
+    e.index = block.GetIndex();
+    e.leader = block.GetLeader();
+    e.blockType = block.GetBlockType();
+    e.parents_count = block.GetParents().size();
+    e.tx_count = block.GetTxsCount();
+    e.size = block.GetSize();
+    e.timestamp = block.GetTimestamp();
+    memcpy(e.hash, b.first.data(), Block::HASH_SIZE);
+    BlockHash groupId(block.GetGroupId());
+    memcpy(e.groupId, groupId.data(), Block::HASH_SIZE);
+
+    memset(&index[i], 0, sizeof(index[i]));
+    memcpy(index[i].hash, e.hash, Block::HASH_SIZE);
+    index[i].entry = i;
+
+    offset = Align8(offset + e.length);
+    ++i;
+  }
+  hdr.total_size = offset;
+
+  sort(index.begin(), index.end(), [](const snapshot_index_t &a, const snapshot_index_t &b){
+    return memcmp(a.hash, b.hash, Block::HASH_SIZE) < 0;
+  });
+
+  string ret(hdr.total_size, 0);
+  char *p = &ret[0];
+  memcpy(p, &hdr, sizeof(hdr));
+  memcpy(p + hdr.table_offset, table.data(), count * sizeof(snapshot_block_t));
+  memcpy(p + hdr.index_offset, index.data(), count * sizeof(snapshot_index_t));
+  i = 0;
+  for (auto &b : blocks){
+    shared_ptr<const Block> block = bg.GetSharedBlock(b.first);
+    if (block == nullptr)
+      return string();
+    block->SerializeTo(p + table[i].offset);
+    ++i;
+  }
+  return ret;
+}
+
+bool BlockgraphSnapshot::Save(const Blockgraph &bg, string path){
+  string serie = Write(bg);
+  if (serie.empty())
+    return false;
+  ofstream output_file(path, ios::out | ios::binary | ios::trunc);
+  if (!output_file.is_open())
+    return false;
+  output_file.write(serie.data(), serie.size());
+  return output_file.good();
+}
+
+bool BlockgraphSnapshot::Open(string path){
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(snapshot_hdr_t)){
+    close(fd);
+    return false;
+  }
+
+  void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED)
+    return false;
+
+  mapping = m;
+  data = (const char*) m;
+  length = st.st_size;
+  if (!IsValid()){
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void BlockgraphSnapshot::Close(){
+  if (mapping != nullptr)
+    munmap(mapping, length);
+  mapping = nullptr;
+  data = nullptr;
+  length = 0;
+  owned.clear();
+}
+
+bool BlockgraphSnapshot::IsValid() const{
+  if (data == nullptr || length < sizeof(snapshot_hdr_t))
+    return false;
+
+  // The offsets are only trusted once the magic and the version match,
+  // and they are compared so that no sum can overflow
+  const snapshot_hdr_t *hdr = (const snapshot_hdr_t*) data;
+  if (memcmp(hdr->magic, SNAPSHOT_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != VERSION)
+    return false;
+  if (hdr->total_size > length)
+    return false;
+  if (hdr->table_offset < sizeof(snapshot_hdr_t) || hdr->table_offset > hdr->index_offset ||
+      hdr->index_offset > hdr->payload_offset || hdr->payload_offset > hdr->total_size)
+    return false;
+  if ((hdr->index_offset - hdr->table_offset) / sizeof(snapshot_block_t) < hdr->block_count)
+    return false;
+  return (hdr->payload_offset - hdr->index_offset) / sizeof(snapshot_index_t) >= hdr->block_count;
+}
+
+size_t BlockgraphSnapshot::GetSize(const char *data){
+  if (data == nullptr)
+    return 0;
+  const snapshot_hdr_t *hdr = (const snapshot_hdr_t*) data;
+  if (memcmp(hdr->magic, SNAPSHOT_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != VERSION)
+    return 0;
+  return hdr->total_size;
+}
+
+int BlockgraphSnapshot::GetBlocksCount() const{
+  return ((const snapshot_hdr_t*) data)->block_count;
+}
+
+const BlockgraphSnapshot::snapshot_block_t& BlockgraphSnapshot::GetEntry(int i) const{
+  const snapshot_hdr_t *hdr = (const snapshot_hdr_t*) data;
+  return ((const snapshot_block_t*) (data + hdr->table_offset))[i];
+}
+
+int BlockgraphSnapshot::Find(string hash) const{
+  const snapshot_hdr_t *hdr = (const snapshot_hdr_t*) data;
+  const snapshot_index_t *first = (const snapshot_index_t*) (data + hdr->index_offset);
+  const snapshot_index_t *last = first + hdr->block_count;
+  BlockHash key(hash);
+
+  const snapshot_index_t *it = lower_bound(first, last, key,
+      [](const snapshot_index_t &e, const BlockHash &k){
+        return memcmp(e.hash, k.data(), Block::HASH_SIZE) < 0;
+      });
+  if (it == last || memcmp(it->hash, key.data(), Block::HASH_SIZE) != 0 ||
+      it->entry >= hdr->block_count)
+    return -1;
+  return it->entry;
+}
+
+BlockView BlockgraphSnapshot::GetBlockView(int i) const{
+  const snapshot_block_t &e = GetEntry(i);
+  const snapshot_hdr_t *hdr = (const snapshot_hdr_t*) data;
+  if (e.offset < hdr->payload_offset || e.offset > hdr->total_size ||
+      e.length > hdr->total_size - e.offset)
+    return BlockView();
+  return BlockView(data + e.offset, e.length);
+}
+
+Block BlockgraphSnapshot::GetBlock(int i) const{
+  return GetBlockView(i).ToBlock();
+}
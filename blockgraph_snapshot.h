@@ -0,0 +1,135 @@
+#ifndef BLOCKGRAPH_SNAPSHOT_H
+#define BLOCKGRAPH_SNAPSHOT_H
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "block.h"
+#include "block_view.h"
+#include "blockgraph.h"
+
+using namespace std;
+
+/**
+ * Snapshot of a whole blockgraph, made to be mmap'd.
+ *
+ * Layout, every section aligned on 8 bytes:
+ *   snapshot_hdr_t
+ *   block header table: one snapshot_block_t per block, in insertion order
+ *   hash index: one snapshot_index_t per block, sorted by hash
+ *   payloads: the serialized blocks (Block::SerializeTo)
+ *
+ * Opening a snapshot only checks the header, so it costs O(1). Lookups go
+ * through the hash index and only the payloads that are read are faulted in.
+ */
+class BlockgraphSnapshot{
+
+  public:
+    static const uint32_t VERSION = 1;
+
+    typedef struct snapshot_hdr_t{
+      char      magic[8];
+      uint32_t  version;
+      uint32_t  block_count;
+      uint64_t  table_offset;
+      uint64_t  index_offset;
+      uint64_t  payload_offset;
+      uint64_t  total_size;
+    } snapshot_hdr_t;
+
+    typedef struct snapshot_block_t{
+      uint64_t  offset;     // offset of the serialized block from the start of the snapshot
+      uint32_t  length;     // length of the serialized block
+      int32_t   index;
+      int32_t   leader;
+      int32_t   blockType;
+      int32_t   parents_count;
+      int32_t   tx_count;
+      int32_t   size;
+      int32_t   reserved;
+      double    timestamp;
+      char      hash[Block::HASH_SIZE];
+      char      groupId[Block::HASH_SIZE];
+    } snapshot_block_t;
+
+    typedef struct snapshot_index_t{
+      char      hash[Block::HASH_SIZE];
+      uint32_t  entry;      // position in the block header table
+      uint32_t  reserved;
+    } snapshot_index_t;
+
+  public:
+    BlockgraphSnapshot();
+    BlockgraphSnapshot(const char *data, size_t length);
+    /**
+     * Snapshot owning its serialized bytes
+     */
+    BlockgraphSnapshot(string serie);
+    BlockgraphSnapshot(const BlockgraphSnapshot &s) = delete;
+    BlockgraphSnapshot& operator=(const BlockgraphSnapshot &s) = delete;
+    ~BlockgraphSnapshot();
+
+  public:
+    /**
+     * Serialize the blockgraph into a snapshot. Return an empty string if
+     * a block cannot be read from the block store.
+     */
+    static string Write(const Blockgraph &bg);
+
+    /**
+     * Write the snapshot of the blockgraph to the file at path.
+     * Return false if the snapshot or the file could not be written.
+     */
+    static bool Save(const Blockgraph &bg, string path);
+
+    /**
+     * mmap the snapshot file at path. Return false if the file could not
+     * be mapped or is not a valid snapshot.
+     */
+    bool Open(string path);
+
+  public:
+    /**
+     * Checks the magic, the version and that every section fits
+     */
+    bool IsValid () const;
+
+    /**
+     * Return the size of the snapshot starting at data as given by its
+     * header, or 0 if data does not start with a header of this version.
+     * Only the header is read, so data must hold at least
+     * sizeof(snapshot_hdr_t) bytes.
+     */
+    static size_t GetSize (const char *data);
+
+    int GetBlocksCount () const;
+
+    /**
+     * Return the header of the i-th block, in insertion order
+     */
+    const snapshot_block_t& GetEntry (int i) const;
+
+    /**
+     * Return the position of the block with the given hash in the header
+     * table, or -1 if it is not in the snapshot
+     */
+    int Find (string hash) const;
+
+    /**
+     * Return a view over the serialized i-th block, or an invalid view if
+     * the block does not lie in the payloads
+     */
+    BlockView GetBlockView (int i) const;
+
+    Block GetBlock (int i) const;
+
+  private:
+    void Close ();
+
+  private:
+    const char*              data;
+    size_t                   length;
+    void*                    mapping;  // set if the snapshot has been mmap'd by Open
+    string                   owned;    // bytes of a snapshot built from a string
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "blockgraph_traversal.h"
+#include <algorithm>
+
+BlockgraphTraversal::BlockgraphTraversal(const Blockgraph &bg) : bg(bg){
+  Update();
+}
+
+void BlockgraphTraversal::Update(){
+  auto blocks = bg.GetBlocks().begin();
+  int count = bg.GetBlocks().Size();
+
+  for (int o = hashes.size(); o < count; ++o){
+    const BlockHash &hash = blocks[o].first;
+    ordinals.Insert(hash, o);
+    hashes.push_back(hash);
+    parents.push_back(vector<int> ());
+    children.push_back(vector<int> ());
+    missing.push_back(0);
+    position.push_back(-1);
+    chain.push_back(-1);
+    chainPos.push_back(-1);
+    reach.push_back(vector<int> ());
+
+    // A block the store cannot read is kept without its parents
+    shared_ptr<const Block> block = bg.GetSharedBlock(hash);
+    vector<string> none;
+    for (auto &p : block != nullptr ? block->GetParents() : none){
+      BlockHash parent(p);
+      const int *po = ordinals.Find(parent);
+      if (po == nullptr){
+        waiting[parent].push_back(o);
+        missing[o]++;
+        continue;
+      }
+      parents[o].push_back(*po);
+      children[*po].push_back(o);
+      if (position[*po] < 0)
+        missing[o]++;
+    }
+
+    // Children received before the block already count it as missing
+    auto it = waiting.find(hash);
+    if (it != waiting.end()){
+      for (int c : it->second){
+        parents[c].push_back(o);
+        children[o].push_back(c);
+      }
+      waiting.erase(it);
+    }
+
+    if (missing[o] == 0)
+      Linearize(o);
+  }
+}
+
+int BlockgraphTraversal::GetBlocksCount() const{
+  return hashes.size();
+}
+
+int BlockgraphTraversal::GetOrdinal(const string &hash) const{
+  const int *o = ordinals.Find(BlockHash(hash));
+  return o == nullptr ? -1 : *o;
+}
+
+string BlockgraphTraversal::GetHash(int ordinal) const{
+  return hashes[ordinal].ToString();
+}
+
+bool BlockgraphTraversal::IsLinearized(int ordinal) const{
+  return position[ordinal] >= 0;
+}
+
+const vector<int>& BlockgraphTraversal::GetTopologicalOrder() const{
+  return order;
+}
+
+int BlockgraphTraversal::GetChainsCount() const{
+  return chainTail.size();
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+bool BlockgraphTraversal::IsAncestor(int ancestor, int block) const{
+  if (ancestor == block || !IsLinearized(ancestor) || !IsLinearized(block))
+    return false;
+  // Chains created after the block hold none of its ancestors
+  int c = chain[ancestor];
+  return c < (int) reach[block].size() && reach[block][c] >= chainPos[ancestor];
+}
+
+bool BlockgraphTraversal::IsAncestor(const string &ancestor, const string &block) const{
+  int a = GetOrdinal(ancestor);
+  int b = GetOrdinal(block);
+  if (a < 0 || b < 0)
+    return false;
+  return IsAncestor(a, b);
+}
+
+vector<string> BlockgraphTraversal::GetAncestors(const string &hash) const{
+  int o = GetOrdinal(hash);
+  if (o < 0 || !IsLinearized(o))
+    return vector<string> ();
+  return ToHashes(Closure(o, parents));
+}
+
+vector<string> BlockgraphTraversal::GetDescendants(const string &hash) const{
+  int o = GetOrdinal(hash);
+  if (o < 0 || !IsLinearized(o))
+    return vector<string> ();
+  return ToHashes(Closure(o, children));
+}
+
+vector<string> BlockgraphTraversal::GetLowestCommonAncestors(const vector<string> &hashes) const{
+  vector<int> blocks;
+  for (auto &h : hashes){
+    int o = GetOrdinal(h);
+    if (o < 0 || !IsLinearized(o))
+      return vector<string> ();
+    blocks.push_back(o);
+  }
+  if (blocks.empty())
+    return vector<string> ();
+
+  // Common ancestors are among the ancestors of any of the blocks
+  vector<int> candidates = Closure(blocks[0], parents);
+  candidates.push_back(blocks[0]);
+  vector<int> common;
+  for (int c : candidates){
+    bool isCommon = true;
+    for (int b : blocks)
+      isCommon = isCommon && (c == b || IsAncestor(c, b));
+    if (isCommon)
+      common.push_back(c);
+  }
+
+  // Visit descendants first: a common ancestor is lowest if it is not an
+  // ancestor of a lowest one already found
+  sort(common.begin(), common.end(), [this](int a, int b){
+    return position[a] > position[b];
+  });
+  vector<int> lowest;
+  for (int c : common){
+    bool isLowest = true;
+    for (int l : lowest)
+      isLowest = isLowest && !IsAncestor(c, l);
+    if (isLowest)
+      lowest.push_back(c);
+  }
+  return ToHashes(lowest);
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+void BlockgraphTraversal::Linearize(int ordinal){
+  vector<int> ready(1, ordinal);
+  while (!ready.empty()){
+    int b = ready.back();
+    ready.pop_back();
+
+    position[b] = order.size();
+    order.push_back(b);
+
+    reach[b].assign(chainTail.size(), -1);
+    for (int p : parents[b]){
+      for (size_t k = 0; k < reach[p].size(); ++k)
+        reach[b][k] = max(reach[b][k], reach[p][k]);
+    }
+
+    // Extend the chain of a parent it ends, else any chain whose last
+    // block is an ancestor, so branches that merged free their chains
+    int c = -1;
+    for (int p : parents[b]){
+      if (chainTail[chain[p]] == p){
+        c = chain[p];
+        break;
+      }
+    }
+    for (int k = 0; c < 0 && k < (int) chainTail.size(); ++k){
+      if (reach[b][k] == chainPos[chainTail[k]])
+        c = k;
+    }
+    if (c < 0){
+      c = chainTail.size();
+      chainTail.push_back(b);
+      reach[b].push_back(-1);
+      chainPos[b] = 0;
+    } else {
+      chainPos[b] = chainPos[chainTail[c]] + 1;
+      chainTail[c] = b;
+    }
+    chain[b] = c;
+    reach[b][c] = chainPos[b];
+
+    for (int child : children[b]){
+      if (--missing[child] == 0)
+        ready.push_back(child);
+    }
+  }
+}
+
+vector<string> BlockgraphTraversal::ToHashes(vector<int> ordinals) const{
+  sort(ordinals.begin(), ordinals.end(), [this](int a, int b){
+    return position[a] < position[b];
+  });
+  vector<string> ret;
+  ret.reserve(ordinals.size());
+  for (int o : ordinals)
+    ret.push_back(GetHash(o));
+  return ret;
+}
+
+vector<int> BlockgraphTraversal::Closure(int ordinal, const vector<vector<int>> &edges) const{
+  vector<char> visited(hashes.size(), 0);
+  vector<int> stack(1, ordinal);
+  vector<int> ret;
+  visited[ordinal] = 1;
+  while (!stack.empty()){
+    int b = stack.back();
+    stack.pop_back();
+    for (int n : edges[b]){
+      // Children may still wait for other parents
+      if (visited[n] || !IsLinearized(n))
+        continue;
+      visited[n] = 1;
+      ret.push_back(n);
+      stack.push_back(n);
+    }
+  }
+  return ret;
+}
@@ -0,0 +1,128 @@
+#ifndef BLOCKGRAPH_TRAVERSAL_H
+#define BLOCKGRAPH_TRAVERSAL_H
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "blockgraph.h"
+#include "flat_hash_map.h"
+
+using namespace std;
+
+/**
+ * Reachability and ordering queries over a blockgraph.
+ *
+ * Blocks get dense ordinals in the order of Blockgraph::GetBlocks(), and
+ * edges are kept as ordinal lists. A block is linearized, i.e. appended to
+ * the topological order, once all its parents are. Linearized blocks are
+ * split into chains: a block extends the chain of a parent it is the last
+ * block of, else any chain whose last block is one of its ancestors, or
+ * starts a new one. Each block keeps, for every chain, the position of its
+ * last ancestor in that chain, which answers IsAncestor in constant time.
+ * Memory is one int per block and chain. Since the chains of merged
+ * branches are extended again, the number of chains is bounded by the
+ * largest number of branches seen at once, not by the number of forks
+ * over the life of the blockgraph. It is the width of the blockgraph in
+ * the worst case.
+ *
+ * Blocks whose parents are missing are known but not linearized, and are
+ * ignored by the queries until their parents arrive.
+ */
+class BlockgraphTraversal{
+
+  public:
+    /**
+     * Index the blocks of bg, which must outlive the traversal
+     */
+    BlockgraphTraversal(const Blockgraph &bg);
+
+  public:
+    /**
+     * Index the blocks added to the blockgraph since the last update
+     */
+    void Update ();
+
+    /**
+     * Get the number of blocks indexed
+     */
+    int GetBlocksCount () const;
+
+    /**
+     * Return the ordinal of the block, or -1 if it is not indexed
+     */
+    int GetOrdinal (const string &hash) const;
+    string GetHash (int ordinal) const;
+
+    /**
+     * Checks if all the ancestors of the block are known
+     */
+    bool IsLinearized (int ordinal) const;
+
+    /**
+     * Gets the ordinals of the linearized blocks, parents before children
+     */
+    const vector<int>& GetTopologicalOrder () const;
+
+    int GetChainsCount () const;
+
+  public:
+    /**
+     * Checks if ancestor is a strict ancestor of block
+     */
+    bool IsAncestor (int ancestor, int block) const;
+    bool IsAncestor (const string &ancestor, const string &block) const;
+
+    /**
+     * Gets the hashes of the strict ancestors of the block, in topological
+     * order
+     */
+    vector<string> GetAncestors (const string &hash) const;
+
+    /**
+     * Gets the hashes of the strict descendants of the block, in
+     * topological order
+     */
+    vector<string> GetDescendants (const string &hash) const;
+
+    /**
+     * Gets the hashes of the lowest common ancestors of the blocks: the
+     * blocks that are an ancestor of, or one of, every given block and
+     * have no descendant with that property
+     */
+    vector<string> GetLowestCommonAncestors (const vector<string> &hashes) const;
+
+  private:
+    /**
+     * Append the block to the topological order, then the blocks waiting
+     * only for it
+     */
+    void Linearize (int ordinal);
+
+    /**
+     * Return the ordinals given in topological order, as hashes
+     */
+    vector<string> ToHashes (vector<int> ordinals) const;
+
+    /**
+     * Gets the ordinals reachable from ordinal following edges, ordinal
+     * excluded
+     */
+    vector<int> Closure (int ordinal, const vector<vector<int>> &edges) const;
+
+  private:
+    const Blockgraph&             bg;
+    FlatHashMap<BlockHash, int>   ordinals;
+    vector<BlockHash>             hashes;     // ordinal -> hash
+    vector<vector<int>>           parents;    // ordinal -> known parents
+    vector<vector<int>>           children;   // ordinal -> known children
+    vector<int>                   missing;    // ordinal -> parents not linearized yet
+    unordered_map<BlockHash, vector<int>> waiting; // unknown parent -> its children
+
+    vector<int>                   order;      // topological order
+    vector<int>                   position;   // ordinal -> position in order, or -1
+    vector<int>                   chain;      // ordinal -> chain
+    vector<int>                   chainPos;   // ordinal -> position in its chain
+    vector<int>                   chainTail;  // chain -> last ordinal
+    vector<vector<int>>           reach;      // ordinal, chain -> last ancestor position
+};
+
+#endif
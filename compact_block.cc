@@ -0,0 +1,215 @@
+#include "compact_block.h"
+
+CompactBlock::CompactBlock(){
+  timestamp = 0.0;
+  index = 0;
+  leader = 0;
+  blockType = Block::regBlock;
+  size = 0;
+  parentsCount = 0;
+  txCount = 0;
+  payloadsEnd = 0;
+}
+
+CompactBlock::CompactBlock(const Block &block){
+  hash =                 BlockHash(block.GetHash());
+  groupId =              BlockHash(block.GetGroupId());
+  merkleRoot =           BlockHash(block.GetMerkleRoot());
+  timestamp =            block.GetTimestamp();
+  index =                block.GetIndex();
+  leader =               block.GetLeader();
+  blockType =            block.GetBlockType();
+  size =                 block.GetSize();
+
+  vector<BlockHash> parents;
+  parents.reserve(block.GetParents().size());
+  for (auto &p : block.GetParents())
+    parents.push_back(BlockHash(p));
+
+  const vector<Transaction> &transactions = block.GetTransactions();
+  size_t payloadsSize = 0;
+  for (auto &t : transactions)
+    payloadsSize += t.GetPayload().size();
+
+  Allocate(parents, transactions.size(), payloadsSize);
+  for (size_t i = 0; i < transactions.size(); ++i){
+    const Transaction &t = transactions[i];
+    SetTxEntry(i, t.GetHash().data(), t.GetTimestamp(), t.GetSize(), t.GetPayload());
+  }
+}
+
+CompactBlock::CompactBlock(const BlockView &view){
+  hash =                 view.GetBlockHash();
+  groupId =              BlockHash(view.GetGroupId());
+  merkleRoot =           BlockHash(view.GetMerkleRoot());
+  timestamp =            view.GetTimestamp();
+  index =                view.GetIndex();
+  leader =               view.GetLeader();
+  blockType =            view.GetBlockType();
+  size =                 view.GetSize();
+
+  vector<BlockHash> parents;
+  parents.reserve(view.GetParentsCount());
+  for (int i = 0; i < view.GetParentsCount(); ++i)
+    parents.push_back(BlockHash(view.GetParent(i)));
+
+  size_t payloadsSize = 0;
+  for (int i = 0; i < view.GetTxsCount(); ++i)
+    payloadsSize += view.GetTransaction(i).GetPayload().size();
+
+  Allocate(parents, view.GetTxsCount(), payloadsSize);
+  for (int i = 0; i < view.GetTxsCount(); ++i){
+    TransactionView t = view.GetTransaction(i);
+    SetTxEntry(i, t.GetTxHash().data(), t.GetTimestamp(), t.GetSize(), t.GetPayload());
+  }
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+const BlockHash& CompactBlock::GetHash() const{
+  return hash;
+}
+
+int CompactBlock::GetIndex() const{
+  return index;
+}
+
+int CompactBlock::GetLeader() const{
+  return leader;
+}
+
+int CompactBlock::GetBlockType() const{
+  return blockType;
+}
+
+const BlockHash& CompactBlock::GetGroupId() const{
+  return groupId;
+}
+
+double CompactBlock::GetTimestamp() const{
+  return timestamp;
+}
+
+int CompactBlock::GetSize() const{
+  return size;
+}
+
+const BlockHash& CompactBlock::GetMerkleRoot() const{
+  return merkleRoot;
+}
+
+int CompactBlock::GetParentsCount() const{
+  return parentsCount;
+}
+
+const BlockHash& CompactBlock::GetParent(int i) const{
+  if (i < INLINE_PARENTS)
+    return parents[i];
+  return ((const BlockHash*) arena.data())[i - INLINE_PARENTS];
+}
+
+int CompactBlock::GetTxsCount() const{
+  return txCount;
+}
+
+TxHash CompactBlock::GetTxHash(int i) const{
+  return TxHash(TxEntry(i).hash);
+}
+
+int CompactBlock::GetTxSize(int i) const{
+  return TxEntry(i).size;
+}
+
+double CompactBlock::GetTxTimestamp(int i) const{
+  return TxEntry(i).timestamp;
+}
+
+string_view CompactBlock::GetTxPayload(int i) const{
+  const tx_entry_t &e = TxEntry(i);
+  return string_view(PayloadsBegin() + e.payloadOffset, e.payloadSize);
+}
+
+int CompactBlock::CalculeTxsSize() const{
+  int txsSize = 0;
+  for (int i = 0; i < txCount; ++i)
+    txsSize += TxEntry(i).size;
+  return txsSize;
+}
+
+size_t CompactBlock::MemoryUsage() const{
+  return sizeof(CompactBlock) + arena.capacity();
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+Transaction CompactBlock::GetTransaction(int i) const{
+  const tx_entry_t &e = TxEntry(i);
+  // Rebuild the stored header, the hash is not calculated again
+  Transaction::tx_t header;
+  header.timestamp = e.timestamp;
+  header.size = e.size;
+  memcpy(header.hash, e.hash, Transaction::HASH_SIZE);
+  return Transaction(header, string(GetTxPayload(i)));
+}
+
+Block CompactBlock::ToBlock() const{
+  vector<string> p;
+  p.reserve(parentsCount);
+  for (int i = 0; i < parentsCount; ++i)
+    p.push_back(GetParent(i).ToString());
+
+  vector<Transaction> transactions;
+  transactions.reserve(txCount);
+  for (int i = 0; i < txCount; ++i)
+    transactions.push_back(GetTransaction(i));
+
+  return Block(hash.ToString(), index, leader, blockType, groupId.ToString(),
+               move(p), timestamp, move(transactions));
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+void CompactBlock::Allocate(const vector<BlockHash> &parents, int txCount, size_t payloadsSize){
+  this->parentsCount = parents.size();
+  this->txCount = txCount;
+  this->payloadsEnd = 0;
+
+  int extraParents = max(parentsCount - INLINE_PARENTS, 0);
+  arena.resize(extraParents * sizeof(BlockHash) + txCount * sizeof(tx_entry_t) +
+               payloadsSize);
+  arena.shrink_to_fit();
+
+  for (int i = 0; i < parentsCount; ++i){
+    if (i < INLINE_PARENTS)
+      this->parents[i] = parents[i];
+    else
+      memcpy(&arena[(i - INLINE_PARENTS) * sizeof(BlockHash)], parents[i].data(),
+             sizeof(BlockHash));
+  }
+}
+
+void CompactBlock::SetTxEntry(int i, const char *hash, double timestamp, int size,
+                              string_view payload){
+  tx_entry_t &e = (tx_entry_t&) TxEntry(i);
+  e.timestamp = timestamp;
+  e.size = size;
+  e.payloadOffset = payloadsEnd;
+  e.payloadSize = payload.size();
+  memcpy(e.hash, hash, Transaction::HASH_SIZE);
+
+  memcpy((char*) PayloadsBegin() + payloadsEnd, payload.data(), payload.size());
+  payloadsEnd += payload.size();
+}
+
+const CompactBlock::tx_entry_t& CompactBlock::TxEntry(int i) const{
+  // Entries start after the extra parents, both are multiples of 8 bytes
+  // so the entries stay aligned
+  size_t begin = max(parentsCount - INLINE_PARENTS, 0) * sizeof(BlockHash);
+  return ((const tx_entry_t*) (arena.data() + begin))[i];
+}
+
+const char* CompactBlock::PayloadsBegin() const{
+  size_t begin = max(parentsCount - INLINE_PARENTS, 0) * sizeof(BlockHash) +
+    txCount * sizeof(tx_entry_t);
+  return arena.data() + begin;
+}
@@ -0,0 +1,120 @@
+#ifndef COMPACT_BLOCK_H
+#define COMPACT_BLOCK_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "block.h"
+#include "block_view.h"
+#include "transaction.h"
+
+using namespace std;
+
+/**
+ * Read-only block laid out for traversal. Hashes are stored inline, the
+ * first parents are kept in the object and everything else lives in one
+ * arena owned by the block:
+ *   extra parents | tx_count tx_entry_t | payloads
+ * Reading a block touches the object and the arena only, instead of one
+ * heap object per string of the Block.
+ */
+class CompactBlock{
+
+  public:
+    static const int INLINE_PARENTS = 2;
+
+  public:
+    // Typedef
+    typedef struct tx_entry_t{
+      double              timestamp;
+      int                 size;  // size of the serialized transaction
+      uint32_t            payloadOffset;  // from the start of the payloads
+      uint32_t            payloadSize;
+      char                hash[Transaction::HASH_SIZE];
+    } tx_entry_t;
+
+  public:
+    //constructor and destructor
+    CompactBlock();
+    CompactBlock(const Block &block);
+    /**
+     * Build the block directly from a serialized one, without going
+     * through Block. The view should be valid.
+     */
+    CompactBlock(const BlockView &view);
+
+  public:
+    //Getters
+    const BlockHash& GetHash (void) const;
+    int GetIndex (void) const;
+    int GetLeader (void) const;
+    int GetBlockType (void) const;
+    const BlockHash& GetGroupId (void) const;
+    double GetTimestamp (void) const;
+    int GetSize (void) const;
+    const BlockHash& GetMerkleRoot (void) const;
+
+    int GetParentsCount (void) const;
+    const BlockHash& GetParent (int i) const;
+
+    int GetTxsCount (void) const;
+    TxHash GetTxHash (int i) const;
+    int GetTxSize (int i) const;
+    double GetTxTimestamp (int i) const;
+    string_view GetTxPayload (int i) const;
+
+    /**
+     * Return the sum of the serialized sizes of the transactions
+     */
+    int CalculeTxsSize () const;
+
+    /**
+     * Bytes owned by the block, the object included
+     */
+    size_t MemoryUsage () const;
+
+  public:
+    /**
+     * Build the i-th transaction. Copies the payload once.
+     */
+    Transaction GetTransaction (int i) const;
+
+    /**
+     * Build a Block with the same fields
+     */
+    Block ToBlock () const;
+
+  private:
+    /**
+     * Size the arena for the given parents and transactions and copy
+     * the parents in place
+     */
+    void Allocate (const vector<BlockHash> &parents, int txCount, size_t payloadsSize);
+
+    /**
+     * Append the i-th transaction, transactions must be added in order
+     */
+    void SetTxEntry (int i, const char *hash, double timestamp, int size,
+                     string_view payload);
+
+    const tx_entry_t& TxEntry (int i) const;
+    const char* PayloadsBegin () const;
+
+  private:
+    BlockHash           hash;
+    BlockHash           groupId;
+    BlockHash           merkleRoot;
+    double              timestamp;
+    int                 index;
+    int                 leader;
+    int                 blockType;
+    int                 size;
+    int                 parentsCount;
+    int                 txCount;
+    uint32_t            payloadsEnd;  // bytes of payloads written so far
+    BlockHash           parents[INLINE_PARENTS];
+    vector<char>        arena;
+};
+
+#endif
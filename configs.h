@@ -41,6 +41,18 @@
 // Transaction creation delay
 // Transaction treatment delay
 
+// Payload of the DATA packets: 1 to send zero-filled virtual bytes that
+// are never materialized, 0 to send random bytes copied from a pool
+#define DATA_PAYLOAD_VIRTUAL 1
+
+// Size of the pool of random bytes used when DATA_PAYLOAD_VIRTUAL is 0
+#define RANDOM_POOL_SIZE 65536  // In bytes
+
+// DATA transfers: payload bytes per chunk, sized for one datagram on a
+// 1500 bytes MTU, and number of chunks in flight per follower
+#define CHUNK_SIZE 1400  // In bytes
+#define TRANSFER_WINDOW 32
+
 // Traces output
 #define TRACE std::cout << Simulator::Now().GetSeconds() << " " << "NODE" << " " << node->GetId() << " "
 
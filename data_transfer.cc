@@ -0,0 +1,146 @@
+#include "data_transfer.h"
+#include <algorithm>
+
+TransferSender::TransferSender(){
+  chunksCount = 0;
+  window = 0;
+  base = 0;
+  ackedCount = 0;
+  lostCount = 0;
+  nextSeq = 0;
+}
+
+TransferSender::TransferSender(int dataSize, int chunkSize, int window){
+  this->chunksCount = (dataSize + chunkSize - 1) / chunkSize;
+  this->window = window;
+  base = 0;
+  ackedCount = 0;
+  lostCount = 0;
+  nextSeq = 0;
+  acked.assign(chunksCount, 0);
+  inFlight.assign(chunksCount, 0);
+  sentSeq.assign(chunksCount, -1);
+  resent.assign(chunksCount, 0);
+}
+
+vector<int> TransferSender::NextChunks(){
+  vector<int> ret;
+  int end = min(base + window, chunksCount);
+  for (int i = base; i < end; ++i){
+    if (!acked[i] && !inFlight[i]){
+      inFlight[i] = 1;
+      resent[i] = sentSeq[i] >= 0;
+      sentSeq[i] = nextSeq++;
+      ret.push_back(i);
+    }
+  }
+  return ret;
+}
+
+void TransferSender::OnAck(const string &received){
+  // Latest transmission newly acknowledged, among the chunks sent once
+  int lastSeq = -1;
+  int count = min((int) received.size() * 8, chunksCount);
+  for (int i = 0; i < count; ++i){
+    if (((received[i / 8] >> (i % 8)) & 1) && !acked[i]){
+      acked[i] = 1;
+      inFlight[i] = 0;
+      ackedCount++;
+      if (!resent[i])
+        lastSeq = max(lastSeq, sentSeq[i]);
+    }
+  }
+
+  // A chunk sent later arrived, the missing ones sent before it are lost.
+  // A chunk resent after it stays in flight until it is acknowledged or
+  // times out.
+  int end = min(base + window, chunksCount);
+  for (int i = base; i < end; ++i){
+    if (inFlight[i] && sentSeq[i] < lastSeq){
+      inFlight[i] = 0;
+      lostCount++;
+    }
+  }
+
+  while (base < chunksCount && acked[base])
+    base++;
+}
+
+void TransferSender::OnTimeout(){
+  for (int i = base; i < chunksCount; ++i){
+    if (inFlight[i] && !acked[i]){
+      inFlight[i] = 0;
+      lostCount++;
+    }
+  }
+}
+
+bool TransferSender::IsComplete() const{
+  return ackedCount == chunksCount;
+}
+
+int TransferSender::GetChunksCount() const{
+  return chunksCount;
+}
+
+int TransferSender::GetAckedCount() const{
+  return ackedCount;
+}
+
+int TransferSender::GetLostCount() const{
+  return lostCount;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+TransferReceiver::TransferReceiver(){
+  dataSize = 0;
+  chunkSize = 1;
+  chunksCount = 0;
+  receivedCount = 0;
+}
+
+TransferReceiver::TransferReceiver(int dataSize, int chunkSize){
+  this->dataSize = dataSize;
+  this->chunkSize = chunkSize;
+  chunksCount = (dataSize + chunkSize - 1) / chunkSize;
+  receivedCount = 0;
+  data.resize(dataSize);
+  received.assign((chunksCount + 7) / 8, 0);
+}
+
+int TransferReceiver::GetChunksCount() const{
+  return chunksCount;
+}
+
+char* TransferReceiver::GetChunkData(int chunk){
+  return data.data() + (size_t) chunk * chunkSize;
+}
+
+int TransferReceiver::GetChunkSize(int chunk) const{
+  return min(chunkSize, dataSize - chunk * chunkSize);
+}
+
+bool TransferReceiver::SetReceived(int chunk){
+  if (IsReceived(chunk))
+    return false;
+  received[chunk / 8] |= 1 << (chunk % 8);
+  receivedCount++;
+  return true;
+}
+
+bool TransferReceiver::IsReceived(int chunk) const{
+  return (received[chunk / 8] >> (chunk % 8)) & 1;
+}
+
+bool TransferReceiver::IsComplete() const{
+  return receivedCount == chunksCount;
+}
+
+string TransferReceiver::GetReceivedBitmap() const{
+  return received;
+}
+
+const vector<char>& TransferReceiver::GetData() const{
+  return data;
+}
@@ -0,0 +1,118 @@
+#ifndef DATA_TRANSFER_H
+#define DATA_TRANSFER_H
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Sender side of a chunked transfer to one peer.
+ * The dataset is split in chunks of chunkSize bytes. Chunks are sent in a
+ * sliding window of window chunks starting at the first chunk not
+ * acknowledged yet. Acknowledgements carry the bitmap of the chunks
+ * received (see TransferReceiver::GetReceivedBitmap). Every transmission
+ * gets a sequence number: a chunk in flight is lost, and sent again, once
+ * a chunk transmitted after it is acknowledged. Only chunks sent once
+ * count, since the bitmap does not tell which transmission of a resent
+ * chunk arrived. Other missing chunks are only declared lost by
+ * OnTimeout, so each loss is resent once.
+ */
+class TransferSender{
+
+  public:
+    TransferSender();
+    TransferSender(int dataSize, int chunkSize, int window);
+
+  public:
+    /**
+     * Return the chunks the window allows to send now and mark them in
+     * flight
+     */
+    vector<int> NextChunks ();
+
+    /**
+     * Register an acknowledgement carrying the bitmap of the chunks the
+     * peer received
+     */
+    void OnAck (const string &received);
+
+    /**
+     * Consider every chunk in flight as lost
+     */
+    void OnTimeout ();
+
+    /**
+     * Checks if the peer received every chunk
+     */
+    bool IsComplete () const;
+
+    int GetChunksCount () const;
+    int GetAckedCount () const;
+
+    /**
+     * Get the number of chunks detected as lost so far
+     */
+    int GetLostCount () const;
+
+  private:
+    int               chunksCount;
+    int               window;
+    int               base;       // first chunk not acknowledged
+    int               ackedCount;
+    int               lostCount;
+    vector<char>      acked;
+    vector<char>      inFlight;
+    vector<int>       sentSeq;    // sequence number of the last transmission
+    vector<char>      resent;
+    int               nextSeq;
+};
+
+/**
+ * Receiver side of a chunked transfer. The buffer of the whole dataset is
+ * allocated once and chunks are written in place at their offset.
+ */
+class TransferReceiver{
+
+  public:
+    TransferReceiver();
+    TransferReceiver(int dataSize, int chunkSize);
+
+  public:
+    int GetChunksCount () const;
+
+    /**
+     * Return where the chunk goes in the buffer and its size
+     */
+    char* GetChunkData (int chunk);
+    int GetChunkSize (int chunk) const;
+
+    /**
+     * Mark the chunk as received, once its data is written.
+     * Return false if it was already received.
+     */
+    bool SetReceived (int chunk);
+    bool IsReceived (int chunk) const;
+
+    /**
+     * Checks if every chunk has been received
+     */
+    bool IsComplete () const;
+
+    /**
+     * Return the received chunks, bit i of the bitmap being set if the
+     * chunk i was received
+     */
+    string GetReceivedBitmap () const;
+
+    const vector<char>& GetData () const;
+
+  private:
+    int               dataSize;
+    int               chunkSize;
+    int               chunksCount;
+    int               receivedCount;
+    vector<char>      data;
+    string            received;   // bitmap of the received chunks
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "duplicate_tx_detector.h"
+#include <algorithm>
+
+DuplicateTxDetector::DuplicateTxDetector(){
+  joinsCount = 0;
+  crossBranchDuplicates = 0;
+  inBranchDuplicates = 0;
+}
+
+bool DuplicateTxDetector::AddBlock(const Block &block){
+  vector<BlockHash> parents(block.GetParents().begin(), block.GetParents().end());
+  vector<TxHash> txs;
+  txs.reserve(block.GetTxsCount());
+  for (auto &t : block.GetTransactions())
+    txs.push_back(TxHash(t.GetHash()));
+  return AddBlock(BlockHash(block.GetHash()), block.GetGroupId(), parents, txs);
+}
+
+bool DuplicateTxDetector::AddBlock(const BlockView &block){
+  vector<BlockHash> parents;
+  parents.reserve(block.GetParentsCount());
+  for (int i = 0; i < block.GetParentsCount(); ++i)
+    parents.push_back(block.GetParentHash(i));
+  vector<TxHash> txs;
+  txs.reserve(block.GetTxsCount());
+  for (int i = 0; i < block.GetTxsCount(); ++i)
+    txs.push_back(block.GetTransaction(i).GetTxHash());
+  return AddBlock(block.GetBlockHash(), block.GetGroupId(), parents, txs);
+}
+
+bool DuplicateTxDetector::AddBlock(const BlockHash &hash, const string &groupId,
+                                   const vector<BlockHash> &parents, const vector<TxHash> &txs){
+  int branch = GetBranch(groupId);
+  if (!blockBranches.Insert(hash, branch).second)
+    return false;
+
+  // A block starting a new group after a split has a single parent
+  // component, only blocks with parents in several components join them
+  vector<int> roots;
+  vector<int> branches;
+  for (auto &p : parents){
+    const int *b = blockBranches.Find(p);
+    if (b != nullptr && find(roots.begin(), roots.end(), GetRoot(*b)) == roots.end()){
+      roots.push_back(GetRoot(*b));
+      branches.push_back(*b);
+    }
+  }
+
+  bool isJoin = roots.size() > 1;
+  if (isJoin){
+    if (find(roots.begin(), roots.end(), GetRoot(branch)) == roots.end()){
+      roots.push_back(GetRoot(branch));
+      branches.push_back(branch);
+    }
+
+    lastJoin.block = hash.ToString();
+    lastJoin.branches.clear();
+    lastJoin.duplicatedTxs.clear();
+    for (int b : branches)
+      lastJoin.branches.push_back(groupIds[b]);
+
+    // The smaller sets are merged into the largest one, which becomes the
+    // root of the joined component
+    int root = roots[0];
+    for (int r : roots){
+      if (componentTxs[r].size() > componentTxs[root].size())
+        root = r;
+    }
+    unordered_set<TxHash> &joined = componentTxs[root];
+    unordered_set<TxHash> duplicated;
+    for (int r : roots){
+      if (r == root)
+        continue;
+      for (auto &t : componentTxs[r]){
+        if (!joined.insert(t).second && duplicated.insert(t).second)
+          lastJoin.duplicatedTxs.push_back(t.ToString());
+      }
+      unordered_set<TxHash> ().swap(componentTxs[r]);
+      branchParents[r] = root;
+    }
+
+    joinsCount++;
+    crossBranchDuplicates += lastJoin.duplicatedTxs.size();
+  }
+
+  unordered_set<TxHash> &component = componentTxs[GetRoot(branch)];
+  for (auto &t : txs){
+    if (!component.insert(t).second)
+      inBranchDuplicates++;
+  }
+  return isJoin;
+}
+
+const DuplicateTxDetector::join_t& DuplicateTxDetector::GetLastJoin() const{
+  return lastJoin;
+}
+
+int DuplicateTxDetector::GetJoinsCount() const{
+  return joinsCount;
+}
+
+int DuplicateTxDetector::GetCrossBranchDuplicates() const{
+  return crossBranchDuplicates;
+}
+
+int DuplicateTxDetector::GetInBranchDuplicates() const{
+  return inBranchDuplicates;
+}
+
+int DuplicateTxDetector::GetBranch(const string &groupId){
+  auto it = branchOrdinals.find(groupId);
+  if (it != branchOrdinals.end())
+    return it->second;
+
+  int branch = groupIds.size();
+  branchOrdinals.insert({groupId, branch});
+  groupIds.push_back(groupId);
+  branchParents.push_back(branch);
+  componentTxs.push_back(unordered_set<TxHash> ());
+  return branch;
+}
+
+int DuplicateTxDetector::GetRoot(int branch){
+  // Path halving keeps the components flat
+  while (branchParents[branch] != branch){
+    branchParents[branch] = branchParents[branchParents[branch]];
+    branch = branchParents[branch];
+  }
+  return branch;
+}
@@ -0,0 +1,91 @@
+#ifndef DUPLICATE_TX_DETECTOR_H
+#define DUPLICATE_TX_DETECTOR_H
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "block.h"
+#include "block_view.h"
+#include "transaction.h"
+#include "flat_hash_map.h"
+
+using namespace std;
+
+/**
+ * Detects transactions included by more than one branch of the
+ * blockgraph. A branch is the set of blocks of a group: during a
+ * partition each group extends its own branch. Branches joined by a block
+ * with parents in several of them, typically a merge block, form a
+ * component (union-find over the branches) and share a single set of
+ * transactions. At a join the smaller sets are merged into the largest,
+ * and the transactions found in several of them are reported as
+ * duplicated. A group extending, or reusing after a later split, a branch
+ * already joined stays in the joined component.
+ */
+class DuplicateTxDetector{
+
+  public:
+    // Typedef
+    typedef struct join_t{
+      string              block;  // hash of the block joining the branches
+      vector<string>      branches;  // group ids of the joined branches
+      vector<string>      duplicatedTxs;  // in more than one joined branch
+    } join_t;
+
+  public:
+    DuplicateTxDetector();
+
+  public:
+    /**
+     * Register a block, whose parents should have been added before.
+     * Returns true if the block joins branches of different components,
+     * and the join is then given by GetLastJoin().
+     */
+    bool AddBlock (const Block &block);
+    bool AddBlock (const BlockView &block);
+
+    const join_t& GetLastJoin () const;
+
+    /**
+     * Get the number of joins seen so far
+     */
+    int GetJoinsCount () const;
+
+    /**
+     * Get the number of transactions found in several branches at a join
+     */
+    int GetCrossBranchDuplicates () const;
+
+    /**
+     * Get the number of transactions included twice in the same component
+     */
+    int GetInBranchDuplicates () const;
+
+  private:
+    bool AddBlock (const BlockHash &hash, const string &groupId,
+                   const vector<BlockHash> &parents, const vector<TxHash> &txs);
+
+    /**
+     * Return the ordinal of the branch of the group, creating it if needed
+     */
+    int GetBranch (const string &groupId);
+
+    /**
+     * Return the branch at the root of the component of branch
+     */
+    int GetRoot (int branch);
+
+  private:
+    FlatHashMap<BlockHash, int>         blockBranches;  // block -> branch
+    unordered_map<string, int>          branchOrdinals; // group id -> branch
+    vector<string>                      groupIds;       // branch -> group id
+    vector<int>                         branchParents;  // branch -> parent branch in its component
+    vector<unordered_set<TxHash>>       componentTxs;   // root branch -> transactions of the component, empty for the others
+
+    join_t                              lastJoin;
+    int                                 joinsCount;
+    int                                 crossBranchDuplicates;
+    int                                 inBranchDuplicates;
+};
+
+#endif
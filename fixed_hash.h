@@ -0,0 +1,100 @@
+#ifndef FIXED_HASH_H
+#define FIXED_HASH_H
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+using namespace std;
+
+/**
+ * Fixed-width hash value stored inline. N is the hash size of the hashed
+ * object (Block::HASH_SIZE, Transaction::HASH_SIZE). Shorter strings are
+ * padded with 0, longer ones are truncated.
+ */
+template<int N>
+class FixedHash{
+
+  public:
+    static const int SIZE = N;
+
+  public:
+    FixedHash(){
+      memset(bytes, 0, N);
+    }
+
+    FixedHash(const string &hash){
+      size_t n = hash.size() < (size_t)N ? hash.size() : N;
+      memcpy(bytes, hash.data(), n);
+      memset(bytes + n, 0, N - n);
+    }
+
+    FixedHash(const char *hash){
+      memcpy(bytes, hash, N);
+    }
+
+  public:
+    const char* data() const{
+      return (const char*) bytes;
+    }
+
+    string ToString() const{
+      return string((const char*) bytes, N);
+    }
+
+    /**
+     * Compares 8 bytes at a time, then the remaining tail
+     */
+    bool operator==(const FixedHash &h) const{
+      int i = 0;
+      for (; i + 8 <= N; i += 8){
+        uint64_t a, b;
+        memcpy(&a, bytes + i, 8);
+        memcpy(&b, h.bytes + i, 8);
+        if (a != b)
+          return false;
+      }
+      return memcmp(bytes + i, h.bytes + i, N - i) == 0;
+    }
+
+    bool operator!=(const FixedHash &h) const{
+      return !(*this == h);
+    }
+
+    bool operator<(const FixedHash &h) const{
+      return memcmp(bytes, h.bytes, N) < 0;
+    }
+
+    /**
+     * Mixes every word of the hash. Transaction hashes are decimal digits
+     * followed by padding, so no single word can be used as is.
+     */
+    size_t Hash() const{
+      uint64_t h = 0x9e3779b97f4a7c15ULL;
+      int i = 0;
+      for (; i + 8 <= N; i += 8){
+        uint64_t w;
+        memcpy(&w, bytes + i, 8);
+        h = (h ^ w) * 0xff51afd7ed558ccdULL;
+        h ^= h >> 32;
+      }
+      for (; i < N; ++i)
+        h = (h ^ bytes[i]) * 0x100000001b3ULL;
+      h ^= h >> 29;
+      return (size_t) h;
+    }
+
+  private:
+    unsigned char bytes[N];
+};
+
+namespace std{
+  template<int N>
+  struct hash<FixedHash<N>>{
+    size_t operator()(const FixedHash<N> &h) const{
+      return h.Hash();
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <functional>
+
+using namespace std;
+
+/**
+ * Open-addressing hash map with linear probing.
+ * Entries are kept in a dense vector in insertion order and the probe table
+ * only holds their positions, so growing the table never moves a value.
+ * Entries cannot be erased: the blockgraph only ever grows.
+ */
+template<typename K, typename V, typename H = hash<K>>
+class FlatHashMap{
+
+  public:
+    typedef pair<K, V> value_type;
+    typedef typename vector<value_type>::iterator iterator;
+    typedef typename vector<value_type>::const_iterator const_iterator;
+
+  public:
+    FlatHashMap(){
+      slots.assign(MIN_CAPACITY, EMPTY);
+    }
+
+  public:
+    /**
+     * Return a pointer to the value of key, or nullptr if key is absent
+     */
+    V* Find(const K &key){
+      uint32_t slot = slots[Probe(key)];
+      return slot == EMPTY ? nullptr : &entries[slot].second;
+    }
+
+    const V* Find(const K &key) const{
+      uint32_t slot = slots[Probe(key)];
+      return slot == EMPTY ? nullptr : &entries[slot].second;
+    }
+
+    bool Contains(const K &key) const{
+      return slots[Probe(key)] != EMPTY;
+    }
+
+    /**
+     * Insert the pair (key, value) if key is absent. Return the value stored
+     * for key and whether it has been inserted.
+     */
+    pair<V*, bool> Insert(const K &key, const V &value){
+      size_t pos = Probe(key);
+      if (slots[pos] != EMPTY)
+        return make_pair(&entries[slots[pos]].second, false);
+
+      entries.push_back(make_pair(key, value));
+      slots[pos] = entries.size() - 1;
+      if (entries.size() * 2 > slots.size())
+        Rehash(slots.size() * 2);
+      return make_pair(&entries.back().second, true);
+    }
+
+    void Reserve(size_t n){
+      entries.reserve(n);
+      size_t capacity = slots.size();
+      while (n * 2 > capacity)
+        capacity *= 2;
+      if (capacity != slots.size())
+        Rehash(capacity);
+    }
+
+    void Clear(){
+      entries.clear();
+      slots.assign(MIN_CAPACITY, EMPTY);
+    }
+
+    size_t Size() const{
+      return entries.size();
+    }
+
+    iterator begin(){ return entries.begin(); }
+    iterator end(){ return entries.end(); }
+    const_iterator begin() const{ return entries.begin(); }
+    const_iterator end() const{ return entries.end(); }
+
+  private:
+    /**
+     * Return the slot holding key, or the empty slot where it would go
+     */
+    size_t Probe(const K &key) const{
+      size_t mask = slots.size() - 1;
+      size_t pos = hasher(key) & mask;
+      while (slots[pos] != EMPTY && !(entries[slots[pos]].first == key))
+        pos = (pos + 1) & mask;
+      return pos;
+    }
+
+    void Rehash(size_t capacity){
+      slots.assign(capacity, EMPTY);
+      size_t mask = capacity - 1;
+      for (uint32_t i = 0; i < entries.size(); ++i){
+        size_t pos = hasher(entries[i].first) & mask;
+        while (slots[pos] != EMPTY)
+          pos = (pos + 1) & mask;
+        slots[pos] = i;
+      }
+    }
+
+  private:
+    static constexpr size_t MIN_CAPACITY = 16; // must be a power of 2
+    static constexpr uint32_t EMPTY = 0xffffffff;
+
+    vector<value_type> entries; // values in insertion order
+    vector<uint32_t> slots;     // probe table of positions in entries
+    H hasher;
+};
+
+#endif
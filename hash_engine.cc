@@ -0,0 +1,301 @@
+#include "hash_engine.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define HASH_ENGINE_X86
+#endif
+
+/**
+ * Slicing-by-8 tables for a reflected CRC polynomial.
+ * table[0] is the usual byte-at-a-time table.
+ */
+struct CrcTables{
+  uint32_t table[8][256];
+
+  CrcTables(uint32_t polynomial){
+    for (uint32_t i = 0; i < 256; ++i){
+      uint32_t crc = i;
+      for (int k = 0; k < 8; ++k)
+        crc = (crc & 1) ? (crc >> 1) ^ polynomial : crc >> 1;
+      table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i){
+      for (int t = 1; t < 8; ++t)
+        table[t][i] = (table[t-1][i] >> 8) ^ table[0][table[t-1][i] & 0xff];
+    }
+  }
+};
+
+static const CrcTables& Crc32Tables(){
+  static const CrcTables tables(0xedb88320);
+  return tables;
+}
+
+static const CrcTables& Crc32cTables(){
+  static const CrcTables tables(0x82f63b78);
+  return tables;
+}
+
+static uint32_t Slice8(const CrcTables &t, const char *data, size_t length){
+  const unsigned char *p = (const unsigned char*) data;
+  uint32_t crc = 0xffffffff;
+
+  while (length >= 8){
+    uint32_t lo, hi;
+    memcpy(&lo, p, 4);
+    memcpy(&hi, p + 4, 4);
+    lo ^= crc;
+    crc = t.table[7][lo & 0xff] ^ t.table[6][(lo >> 8) & 0xff] ^
+          t.table[5][(lo >> 16) & 0xff] ^ t.table[4][lo >> 24] ^
+          t.table[3][hi & 0xff] ^ t.table[2][(hi >> 8) & 0xff] ^
+          t.table[1][(hi >> 16) & 0xff] ^ t.table[0][hi >> 24];
+    p += 8;
+    length -= 8;
+  }
+  while (length--)
+    crc = (crc >> 8) ^ t.table[0][(crc ^ *p++) & 0xff];
+
+  return crc ^ 0xffffffff;
+}
+
+#ifdef HASH_ENGINE_X86
+__attribute__((target("sse4.2")))
+static uint32_t Crc32cSse42(const char *data, size_t length){
+  const unsigned char *p = (const unsigned char*) data;
+  uint32_t crc = 0xffffffff;
+#if defined(__x86_64__)
+  uint64_t crc64 = crc;
+  while (length >= 8){
+    uint64_t v;
+    memcpy(&v, p, 8);
+    crc64 = _mm_crc32_u64(crc64, v);
+    p += 8;
+    length -= 8;
+  }
+  crc = (uint32_t) crc64;
+#endif
+  while (length--)
+    crc = _mm_crc32_u8(crc, *p++);
+  return crc ^ 0xffffffff;
+}
+#endif
+
+uint32_t HashEngine::Crc32(const char *data, size_t length){
+  return Slice8(Crc32Tables(), data, length);
+}
+
+uint32_t HashEngine::Crc32Bytewise(const char *data, size_t length){
+  const uint32_t *table = Crc32Tables().table[0];
+  const unsigned char *p = (const unsigned char*) data;
+  uint32_t crc = 0xffffffff;
+  while (length--)
+    crc = (crc >> 8) ^ table[(crc ^ *p++) & 0xff];
+  return crc ^ 0xffffffff;
+}
+
+uint32_t HashEngine::Crc32c(const char *data, size_t length){
+#ifdef HASH_ENGINE_X86
+  static const bool hardware = HasSse42();
+  if (hardware)
+    return Crc32cSse42(data, length);
+#endif
+  return Crc32cSoftware(data, length);
+}
+
+uint32_t HashEngine::Crc32cSoftware(const char *data, size_t length){
+  return Slice8(Crc32cTables(), data, length);
+}
+
+bool HashEngine::HasSse42(){
+#ifdef HASH_ENGINE_X86
+  return __builtin_cpu_supports("sse4.2");
+#else
+  return false;
+#endif
+}
+
+bool HashEngine::HasShaNi(){
+#ifdef HASH_ENGINE_X86
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    return false;
+  return (ebx & (1u << 29)) && __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3");
+#else
+  return false;
+#endif
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+static const uint32_t SHA256_K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static inline uint32_t Rotr(uint32_t x, int n){
+  return (x >> n) | (x << (32 - n));
+}
+
+static void Sha256Block(uint32_t state[8], const unsigned char *block){
+  uint32_t w[64];
+  for (int i = 0; i < 16; ++i)
+    w[i] = ((uint32_t) block[4*i] << 24) | ((uint32_t) block[4*i+1] << 16) |
+           ((uint32_t) block[4*i+2] << 8) | (uint32_t) block[4*i+3];
+  for (int i = 16; i < 64; ++i){
+    uint32_t s0 = Rotr(w[i-15], 7) ^ Rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+    uint32_t s1 = Rotr(w[i-2], 17) ^ Rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+    w[i] = w[i-16] + s0 + w[i-7] + s1;
+  }
+
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+  for (int i = 0; i < 64; ++i){
+    uint32_t S1 = Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25);
+    uint32_t ch = (e & f) ^ (~e & g);
+    uint32_t t1 = h + S1 + ch + SHA256_K[i] + w[i];
+    uint32_t S0 = Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22);
+    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = S0 + maj;
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+
+  state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+  state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+static void Sha256BlocksSoftware(uint32_t state[8], const unsigned char *p, size_t blocks){
+  for (size_t i = 0; i < blocks; ++i)
+    Sha256Block(state, p + 64 * i);
+}
+
+#ifdef HASH_ENGINE_X86
+/**
+ * SHA-256 compression with the SHA extensions. The state is kept as ABEF
+ * and CDGH words, the layout sha256rnds2 works on.
+ */
+__attribute__((target("sha,ssse3,sse4.1")))
+static void Sha256BlocksShaNi(uint32_t state[8], const unsigned char *p, size_t blocks){
+  const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*) &state[0]), 0xB1); // CDAB
+  __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*) &state[4]), 0x1B); // EFGH
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+
+  for (size_t b = 0; b < blocks; ++b, p += 64){
+    __m128i abef = state0;
+    __m128i cdgh = state1;
+    __m128i w[4]; // last 16 words of the message schedule
+
+    for (int g = 0; g < 16; ++g){
+      __m128i m;
+      if (g < 4){
+        m = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (p + 16 * g)), MASK);
+      } else {
+        m = _mm_sha256msg1_epu32(w[g % 4], w[(g + 1) % 4]);
+        m = _mm_add_epi32(m, _mm_alignr_epi8(w[(g + 3) % 4], w[(g + 2) % 4], 4));
+        m = _mm_sha256msg2_epu32(m, w[(g + 3) % 4]);
+      }
+      w[g % 4] = m;
+
+      __m128i msg = _mm_add_epi32(m, _mm_loadu_si128((const __m128i*) &SHA256_K[4 * g]));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      msg = _mm_shuffle_epi32(msg, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    }
+
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8); // HGFE
+  _mm_storeu_si128((__m128i*) &state[0], state0);
+  _mm_storeu_si128((__m128i*) &state[4], state1);
+}
+#endif
+
+static void Sha256Blocks(uint32_t state[8], const unsigned char *p, size_t blocks){
+#ifdef HASH_ENGINE_X86
+  static const bool hardware = HashEngine::HasShaNi();
+  if (hardware)
+    return Sha256BlocksShaNi(state, p, blocks);
+#endif
+  Sha256BlocksSoftware(state, p, blocks);
+}
+
+typedef void (*Sha256BlocksFn)(uint32_t state[8], const unsigned char *p, size_t blocks);
+
+static void Sha256With(Sha256BlocksFn blocksFn, const char *data, size_t length,
+                       unsigned char *digest){
+  uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                       0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  const unsigned char *p = (const unsigned char*) data;
+  uint64_t bits = (uint64_t) length * 8;
+
+  blocksFn(state, p, length / 64);
+  p += length - length % 64;
+  length %= 64;
+
+  // Padding: 0x80, zeros, then the message length in bits, big endian
+  unsigned char last[128];
+  memset(last, 0, sizeof(last));
+  memcpy(last, p, length);
+  last[length] = 0x80;
+  size_t last_size = (length + 9 <= 64) ? 64 : 128;
+  for (int i = 0; i < 8; ++i)
+    last[last_size - 1 - i] = (unsigned char) (bits >> (8 * i));
+  blocksFn(state, last, last_size / 64);
+
+  for (int i = 0; i < 8; ++i){
+    digest[4*i] = (unsigned char) (state[i] >> 24);
+    digest[4*i+1] = (unsigned char) (state[i] >> 16);
+    digest[4*i+2] = (unsigned char) (state[i] >> 8);
+    digest[4*i+3] = (unsigned char) state[i];
+  }
+}
+
+void HashEngine::Sha256(const char *data, size_t length, unsigned char *digest){
+  Sha256With(Sha256Blocks, data, length, digest);
+}
+
+void HashEngine::Sha256Software(const char *data, size_t length, unsigned char *digest){
+  Sha256With(Sha256BlocksSoftware, data, length, digest);
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+void HashEngine::Digest(Algorithm algorithm, const char *data, size_t length,
+                        char *out, size_t size){
+  unsigned char digest[SHA256_SIZE];
+  size_t digest_size = 0;
+
+  if (algorithm == SHA256){
+    Sha256(data, length, digest);
+    digest_size = SHA256_SIZE;
+  } else {
+    uint32_t crc = (algorithm == CRC32C) ? Crc32c(data, length) : Crc32(data, length);
+    memcpy(digest, &crc, sizeof(crc));
+    digest_size = sizeof(crc);
+  }
+
+  size_t n = digest_size < size ? digest_size : size;
+  memcpy(out, digest, n);
+  memset(out + n, 0, size - n);
+}
+
+string HashEngine::Digest(Algorithm algorithm, const string &data, size_t size){
+  string ret(size, 0);
+  Digest(algorithm, data.data(), data.size(), &ret[0], size);
+  return ret;
+}
@@ -0,0 +1,71 @@
+#ifndef HASH_ENGINE_H
+#define HASH_ENGINE_H
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+/**
+ * Hashing algorithms used by blocks and transactions.
+ * Digests are raw binary. CRC32C uses the SSE4.2 crc32 instruction and
+ * SHA-256 the SHA extensions when the CPU has them, which is checked once
+ * at runtime.
+ */
+class HashEngine{
+
+  public:
+    enum Algorithm{CRC32=0, CRC32C=1, SHA256=2};
+    static const int SHA256_SIZE = 32;
+
+  public:
+    /**
+     * CRC32 (IEEE 802.3), slicing-by-8
+     */
+    static uint32_t Crc32 (const char *data, size_t length);
+
+    /**
+     * CRC32 (IEEE 802.3), one byte at a time. Reference implementation
+     */
+    static uint32_t Crc32Bytewise (const char *data, size_t length);
+
+    /**
+     * CRC32C (Castagnoli), hardware accelerated when available
+     */
+    static uint32_t Crc32c (const char *data, size_t length);
+
+    /**
+     * CRC32C (Castagnoli), slicing-by-8
+     */
+    static uint32_t Crc32cSoftware (const char *data, size_t length);
+
+    /**
+     * SHA-256 of data, written to digest which must hold SHA256_SIZE bytes
+     */
+    static void Sha256 (const char *data, size_t length, unsigned char *digest);
+
+    /**
+     * SHA-256 of data, portable implementation
+     */
+    static void Sha256Software (const char *data, size_t length, unsigned char *digest);
+
+    /**
+     * Checks if the CPU supports SSE4.2
+     */
+    static bool HasSse42 ();
+
+    /**
+     * Checks if the CPU supports the SHA extensions
+     */
+    static bool HasShaNi ();
+
+    /**
+     * Write a size-byte raw digest of data to out. Digests shorter than size
+     * are padded with 0, longer ones are truncated.
+     */
+    static void Digest (Algorithm algorithm, const char *data, size_t length,
+                        char *out, size_t size);
+    static string Digest (Algorithm algorithm, const string &data, size_t size);
+};
+
+#endif
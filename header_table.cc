@@ -0,0 +1,184 @@
+#include "header_table.h"
+
+HeaderTable::HeaderTable(){
+}
+
+void HeaderTable::Add(const Block &block){
+  Add(block.GetGroupId(), block.GetIndex(), block.GetLeader(), block.GetBlockType(),
+      block.GetTimestamp(), block.GetSize(), block.GetTxsCount());
+}
+
+void HeaderTable::Add(const BlockView &block){
+  Add(block.GetGroupId(), block.GetIndex(), block.GetLeader(), block.GetBlockType(),
+      block.GetTimestamp(), block.GetSize(), block.GetTxsCount());
+}
+
+void HeaderTable::Add(const string &groupId, int index, int leader, int blockType,
+                      double timestamp, int size, int txsCount){
+  auto it = groupOrdinals.find(groupId);
+  int group;
+  if (it == groupOrdinals.end()){
+    group = groupIds.size();
+    groupIds.push_back(groupId);
+    groupOrdinals.insert({groupId, group});
+  } else {
+    group = it->second;
+  }
+
+  indexes.push_back(index);
+  leaders.push_back(leader);
+  blockTypes.push_back(blockType);
+  timestamps.push_back(timestamp);
+  sizes.push_back(size);
+  txsCounts.push_back(txsCount);
+  groups.push_back(group);
+}
+
+void HeaderTable::Reserve(size_t n){
+  indexes.reserve(n);
+  leaders.reserve(n);
+  blockTypes.reserve(n);
+  timestamps.reserve(n);
+  sizes.reserve(n);
+  txsCounts.reserve(n);
+  groups.reserve(n);
+}
+
+size_t HeaderTable::Size() const{
+  return indexes.size();
+}
+
+int HeaderTable::GetGroupOrdinal(const string &groupId) const{
+  auto it = groupOrdinals.find(groupId);
+  if (it == groupOrdinals.end())
+    return -1;
+  return it->second;
+}
+
+const string& HeaderTable::GetGroupId(int ordinal) const{
+  return groupIds[ordinal];
+}
+
+int HeaderTable::GetGroupsCount() const{
+  return groupIds.size();
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+const vector<int>& HeaderTable::GetIndexes() const{
+  return indexes;
+}
+
+const vector<int>& HeaderTable::GetLeaders() const{
+  return leaders;
+}
+
+const vector<int>& HeaderTable::GetBlockTypes() const{
+  return blockTypes;
+}
+
+const vector<double>& HeaderTable::GetTimestamps() const{
+  return timestamps;
+}
+
+const vector<int>& HeaderTable::GetSizes() const{
+  return sizes;
+}
+
+const vector<int>& HeaderTable::GetTxsCounts() const{
+  return txsCounts;
+}
+
+const vector<int>& HeaderTable::GetGroups() const{
+  return groups;
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+HeaderTable::filter_t HeaderTable::All(){
+  filter_t filter;
+  filter.minIndex = numeric_limits<int>::min();
+  filter.maxIndex = numeric_limits<int>::max();
+  filter.minTimestamp = -numeric_limits<double>::infinity();
+  filter.maxTimestamp = numeric_limits<double>::infinity();
+  filter.group = ANY;
+  filter.leader = ANY;
+  filter.blockType = ANY;
+  return filter;
+}
+
+void HeaderTable::Scan(const filter_t &filter, vector<uint32_t> &rows) const{
+  uint8_t mask[BATCH];
+  for (size_t begin = 0; begin < Size(); begin += BATCH){
+    size_t end = min(begin + BATCH, Size());
+    Match(filter, begin, end, mask);
+    for (size_t i = begin; i < end; ++i){
+      if (mask[i - begin])
+        rows.push_back(i);
+    }
+  }
+}
+
+size_t HeaderTable::Count(const filter_t &filter) const{
+  uint8_t mask[BATCH];
+  size_t count = 0;
+  for (size_t begin = 0; begin < Size(); begin += BATCH){
+    size_t end = min(begin + BATCH, Size());
+    Match(filter, begin, end, mask);
+    for (size_t i = 0; i < end - begin; ++i)
+      count += mask[i];
+  }
+  return count;
+}
+
+int64_t HeaderTable::SumSizes(const filter_t &filter) const{
+  return Sum(filter, sizes);
+}
+
+int64_t HeaderTable::SumTxsCounts(const filter_t &filter) const{
+  return Sum(filter, txsCounts);
+}
+
+// +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+void HeaderTable::Match(const filter_t &filter, size_t begin, size_t end, uint8_t *mask) const{
+  const int *index = indexes.data();
+  const int *leader = leaders.data();
+  const int *blockType = blockTypes.data();
+  const double *timestamp = timestamps.data();
+  const int *group = groups.data();
+
+  size_t n = end - begin;
+
+  // One pass per column keeps each loop on a single element type
+  for (size_t i = 0; i < n; ++i)
+    mask[i] = (index[begin + i] >= filter.minIndex) & (index[begin + i] <= filter.maxIndex);
+  for (size_t i = 0; i < n; ++i)
+    mask[i] &= (timestamp[begin + i] >= filter.minTimestamp) &
+      (timestamp[begin + i] < filter.maxTimestamp);
+  if (filter.group != ANY){
+    for (size_t i = 0; i < n; ++i)
+      mask[i] &= group[begin + i] == filter.group;
+  }
+  if (filter.leader != ANY){
+    for (size_t i = 0; i < n; ++i)
+      mask[i] &= leader[begin + i] == filter.leader;
+  }
+  if (filter.blockType != ANY){
+    for (size_t i = 0; i < n; ++i)
+      mask[i] &= blockType[begin + i] == filter.blockType;
+  }
+}
+
+int64_t HeaderTable::Sum(const filter_t &filter, const vector<int> &column) const{
+  uint8_t mask[BATCH];
+  int64_t sum = 0;
+  for (size_t begin = 0; begin < Size(); begin += BATCH){
+    size_t end = min(begin + BATCH, Size());
+    Match(filter, begin, end, mask);
+    const int *value = column.data() + begin;
+    for (size_t i = 0; i < end - begin; ++i)
+      sum += mask[i] * (int64_t) value[i];
+  }
+  return sum;
+}
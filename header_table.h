@@ -0,0 +1,129 @@
+#ifndef HEADER_TABLE_H
+#define HEADER_TABLE_H
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <limits>
+#include <cstdint>
+#include "block.h"
+#include "block_view.h"
+
+using namespace std;
+
+/**
+ * Columnar copy of the block headers of a blockgraph. Row i describes the
+ * i-th block added, so rows follow the insertion order of
+ * Blockgraph::GetBlocks(). Each field is kept in its own array so scans
+ * read contiguous memory and can be vectorized by the compiler.
+ */
+class HeaderTable{
+
+  public:
+    static const int ANY = numeric_limits<int>::min();
+
+    /**
+     * Conjunction of conditions on a row. Ranges are inclusive except the
+     * creation time, which is [minTimestamp, maxTimestamp). ANY as group,
+     * leader or blockType matches every value.
+     */
+    typedef struct filter_t{
+      int                 minIndex;
+      int                 maxIndex;
+      double              minTimestamp;
+      double              maxTimestamp;
+      int                 group;  // ordinal given by GetGroupOrdinal
+      int                 leader;
+      int                 blockType;
+    } filter_t;
+
+  public:
+    HeaderTable();
+
+  public:
+    /**
+     * Append the header of block as a new row
+     */
+    void Add (const Block &block);
+    void Add (const BlockView &block);
+
+    void Reserve (size_t n);
+
+    /**
+     * Get the number of rows
+     */
+    size_t Size () const;
+
+    /**
+     * Return the ordinal of the group, or -1 if no block of the table is
+     * part of it. A filter on -1 matches no row.
+     */
+    int GetGroupOrdinal (const string &groupId) const;
+    const string& GetGroupId (int ordinal) const;
+    int GetGroupsCount () const;
+
+  public:
+    // Columns
+    const vector<int>& GetIndexes () const;
+    const vector<int>& GetLeaders () const;
+    const vector<int>& GetBlockTypes () const;
+    const vector<double>& GetTimestamps () const;
+    const vector<int>& GetSizes () const;
+    const vector<int>& GetTxsCounts () const;
+    const vector<int>& GetGroups () const;
+
+  public:
+    /**
+     * Return a filter matching every row
+     */
+    static filter_t All ();
+
+    /**
+     * Append to rows the rows matching filter, in increasing order
+     */
+    void Scan (const filter_t &filter, vector<uint32_t> &rows) const;
+
+    /**
+     * Get the number of rows matching filter
+     */
+    size_t Count (const filter_t &filter) const;
+
+    /**
+     * Get the sum of the block sizes of the rows matching filter
+     */
+    int64_t SumSizes (const filter_t &filter) const;
+
+    /**
+     * Get the sum of the transaction counts of the rows matching filter
+     */
+    int64_t SumTxsCounts (const filter_t &filter) const;
+
+  private:
+    void Add (const string &groupId, int index, int leader, int blockType,
+              double timestamp, int size, int txsCount);
+
+    /**
+     * Write in mask 1 for the rows of [begin, end) matching filter and
+     * 0 for the others. The loops are branchless so they vectorize.
+     */
+    void Match (const filter_t &filter, size_t begin, size_t end, uint8_t *mask) const;
+
+    /**
+     * Sum column over the rows matching filter
+     */
+    int64_t Sum (const filter_t &filter, const vector<int> &column) const;
+
+  private:
+    static const size_t BATCH = 1024; // rows matched at once by a scan
+
+    vector<int>         indexes;
+    vector<int>         leaders;
+    vector<int>         blockTypes;
+    vector<double>      timestamps;
+    vector<int>         sizes;
+    vector<int>         txsCounts;
+    vector<int>         groups;
+    vector<string>      groupIds; // ordinal -> group id
+    unordered_map<string, int> groupOrdinals;
+};
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * Counts the heap allocations made by read-only traversals of blocks and
+ * of the blockgraph, which should make none.
+ */
+#include <iostream>
+#include <new>
+#include <cstdlib>
+#include <functional>
+
+#include "block.h"
+#include "block_view.h"
+#include "blockgraph.h"
+#include "transaction.h"
+
+using namespace std;
+
+static size_t allocations = 0;
+
+void* operator new(size_t size){
+  allocations++;
+  void *p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr)
+    throw bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept{
+  free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept{
+  free(p);
+}
+
+static int failures = 0;
+
+static void Check(const string &name, const function<void ()> &traversal){
+  size_t before = allocations;
+  traversal();
+  size_t count = allocations - before;
+  cout << "  " << name << " : " << count << " allocations" << endl;
+  if (count != 0)
+    failures++;
+}
+
+static Block MakeBlock(int index, const string &parent, int txsCount){
+  vector<Transaction> transactions;
+  for (int i = 0; i < txsCount; ++i)
+    transactions.push_back(Transaction(to_string(index * 1000 + i), 0,
+                                       string(100 + i, 'a' + i % 26), index + i * 0.01));
+  return Block(to_string(index), index, index % 4, 0, "1", vector<string> (1, parent),
+               index, move(transactions));
+}
+
+int main(int argc, char *argv[]) {
+  Blockgraph bg;
+  string parent = bg.GetAllBlockHashes()[0];
+  for (int i = 1; i <= 100; ++i){
+    Block b = MakeBlock(i, parent, 20);
+    bg.AddBlock(b);
+    parent = b.GetHash();
+  }
+  shared_ptr<const Block> block = bg.GetSharedBlock(parent);
+  string serie(block->SerializedSize(), 0);
+  block->SerializeTo(&serie[0]);
+  volatile size_t sink = 0;
+
+  cout << "Read-only traversals" << endl;
+
+  Check("Block fields", [&](){
+    sink += block->GetHash().size() + block->GetGroupId().size() + block->GetIndex() +
+            block->GetLeader() + block->GetBlockType() + block->GetSize() + block->GetTxsCount();
+    sink += block->GetTimestamp();
+    for (auto &p : block->GetParents())
+      sink += p.size();
+  });
+
+  Check("Block transactions", [&](){
+    for (auto &t : block->GetTransactions())
+      sink += t.GetHash().size() + t.GetPayload().size() + t.GetSize() + t.GetTimestamp();
+    for (int i = 0; i < block->GetTxsCount(); ++i)
+      sink += block->GetTransaction(i).GetPayload()[0];
+  });
+
+  Check("BlockView", [&](){
+    BlockView view(serie);
+    sink += view.IsValid() + view.GetBlockHash().data()[0] + view.GetIndex();
+    for (int i = 0; i < view.GetTxsCount(); ++i){
+      TransactionView t = view.GetTransaction(i);
+      sink += t.GetTxHash().data()[0] + t.GetPayload().size() + t.GetSize();
+    }
+  });
+
+  Check("Blockgraph lookups", [&](){
+    for (auto &b : bg.GetBlocks()){
+      shared_ptr<const Block> shared = bg.GetSharedBlock(b.first);
+      sink += bg.HasBlock(*shared) + bg.HasBlock(shared->GetHash()) + bg.IsChildless(*shared);
+      for (auto &t : shared->GetTransactions())
+        sink += bg.IsTxInBG(t) + bg.CountRepTxInBlockGraph(t);
+    }
+    for (auto &t : bg.GetTips())
+      sink += t.data()[0];
+    sink += bg.GetBlocksCount() + bg.GetBlocksCountInGroup(block->GetGroupId()) +
+            bg.GetTxsPerBlockHistogram().size();
+  });
+
+  if (failures > 0){
+    cout << failures << " traversals allocated" << endl;
+    return 1;
+  }
+  cout << "No allocation" << endl;
+  return 0;
+}
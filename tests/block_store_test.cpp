@@ -0,0 +1,215 @@
+/**
+ * Tests of BlockStore: more blocks than the initial index capacity so that
+ * the index grows, a failed growth, reopening the store, the bounded LRU
+ * cache, and a blockgraph backed by a store that can or cannot be read.
+ */
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "block.h"
+#include "block_store.h"
+#include "blockgraph.h"
+#include "transaction.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void Check(bool ok, const string &what){
+  if (!ok){
+    cout << "FAIL : " << what << endl;
+    failures++;
+  }
+}
+
+static string Serialize(const Block &b){
+  string serie(b.SerializedSize(), 0);
+  b.SerializeTo(&serie[0]);
+  return serie;
+}
+
+static bool Same(shared_ptr<const Block> read, const Block &b){
+  return read != nullptr && Serialize(*read) == Serialize(b);
+}
+
+static Block MakeBlock(int index, const string &parent){
+  vector<Transaction> transactions;
+  for (int i = 0; i < 3; ++i)
+    transactions.push_back(Transaction(to_string(index * 10 + i), 0,
+                                       string(20 + i, 'a' + index % 26), index + i * 0.01));
+  // The hash is padded with '1', the separator keeps it unique
+  return Block(to_string(index) + "-", index, 0, 0, "1", vector<string> (1, parent),
+               index, move(transactions));
+}
+
+static void Remove(const string &path){
+  unlink((path + ".log").c_str());
+  unlink((path + ".idx").c_str());
+  unlink((path + ".idx.tmp").c_str());
+}
+
+static void TestGrowAndReopen(const string &path){
+  // Twice the initial capacity of 1024 slots, with a load factor of 1/2
+  const int count = 3000;
+  vector<Block> blocks;
+  string parent(Block::HASH_SIZE, '0');
+  for (int i = 1; i <= count; ++i){
+    blocks.push_back(MakeBlock(i, parent));
+    parent = blocks.back().GetHash();
+  }
+
+  {
+    BlockStore store(16);
+    Check(store.Open(path), "open new store");
+    for (auto &b : blocks)
+      Check(store.Put(make_shared<const Block>(b)), "put block " + to_string(b.GetIndex()));
+    Check(store.GetBlocksCount() == (size_t) count, "blocks count after grow");
+    Check(store.GetCacheSize() == 16, "cache bounded by its capacity");
+    Check(store.Put(make_shared<const Block>(blocks[0])) && store.GetBlocksCount() == (size_t) count,
+          "put of a stored block");
+    Check(access((path + ".idx.tmp").c_str(), F_OK) != 0, "no temporary index left");
+
+    for (auto &b : blocks){
+      shared_ptr<const Block> read = store.Get(BlockHash(b.GetHash()));
+      Check(Same(read, b), "get block " + to_string(b.GetIndex()));
+    }
+    Check(store.GetCacheSize() == 16, "cache bounded after reads");
+    Check(store.Get(BlockHash(string(Block::HASH_SIZE, 'z'))) == nullptr, "get of a missing block");
+  }
+
+  BlockStore reopened(0);
+  Check(reopened.Open(path), "reopen store");
+  Check(reopened.GetBlocksCount() == (size_t) count, "blocks count after reopen");
+  for (auto &b : blocks){
+    shared_ptr<const Block> read = reopened.Get(BlockHash(b.GetHash()));
+    Check(Same(read, b), "get block after reopen " + to_string(b.GetIndex()));
+  }
+  Check(reopened.GetCacheSize() == 0, "no cache");
+}
+
+static void TestGrowFailure(const string &path){
+  BlockStore store(0);
+  Check(store.Open(path), "open store");
+  vector<Block> blocks;
+  string parent(Block::HASH_SIZE, '0');
+  for (int i = 1; i <= 600; ++i){
+    blocks.push_back(MakeBlock(i, parent));
+    parent = blocks.back().GetHash();
+  }
+
+  // A directory in place of the temporary index makes the growth fail
+  // when the 513th block is put
+  for (int i = 0; i < 512; ++i)
+    store.Put(make_shared<const Block>(blocks[i]));
+  mkdir((path + ".idx.tmp").c_str(), 0755);
+  Check(!store.Put(make_shared<const Block>(blocks[512])), "put fails when the index cannot grow");
+  Check(store.GetBlocksCount() == 512, "blocks count after a failed growth");
+  for (int i = 0; i < 512; ++i)
+    Check(Same(store.Get(BlockHash(blocks[i].GetHash())), blocks[i]),
+          "get block after a failed growth " + to_string(i));
+
+  rmdir((path + ".idx.tmp").c_str());
+  for (int i = 512; i < 600; ++i)
+    Check(store.Put(make_shared<const Block>(blocks[i])), "put after a failed growth " + to_string(i));
+  Check(store.GetBlocksCount() == 600, "blocks count after growth");
+  for (auto &b : blocks)
+    Check(Same(store.Get(BlockHash(b.GetHash())), b), "get block after growth " + to_string(b.GetIndex()));
+}
+
+static void TestLru(const string &path){
+  BlockStore store(2);
+  Check(store.Open(path), "open lru store");
+  string genesis(Block::HASH_SIZE, '0');
+  shared_ptr<const Block> a = make_shared<const Block>(MakeBlock(1, genesis));
+  shared_ptr<const Block> b = make_shared<const Block>(MakeBlock(2, genesis));
+  shared_ptr<const Block> c = make_shared<const Block>(MakeBlock(3, genesis));
+  store.Put(a);
+  store.Put(b);
+  Check(store.Get(BlockHash(a->GetHash())) == a, "cached block is not copied");
+
+  // b is the least recently used and is evicted by c
+  store.Put(c);
+  Check(store.GetCacheSize() == 2, "cache size after eviction");
+  Check(store.Get(BlockHash(a->GetHash())) == a, "recently used block kept");
+  shared_ptr<const Block> read = store.Get(BlockHash(b->GetHash()));
+  Check(read != b && Same(read, *b), "evicted block read from the log");
+}
+
+static void TestBlockgraph(const string &path){
+  Blockgraph bg;
+  Blockgraph expected;
+  string parent = bg.GetAllBlockHashes()[0];
+  string groupId;
+  for (int i = 1; i <= 1500; ++i){
+    Block b = MakeBlock(i, parent);
+    groupId = b.GetGroupId();
+    bg.AddBlock(b);
+    expected.AddBlock(b);
+    parent = b.GetHash();
+    if (i == 100){
+      shared_ptr<BlockStore> store = make_shared<BlockStore>(8);
+      Check(store->Open(path), "open blockgraph store");
+      bg.SetBlockStore(store);
+    }
+  }
+
+  Check(bg.GetBlocksCount() == expected.GetBlocksCount(), "blockgraph blocks count");
+  Check(bg.GetByteSize() == expected.GetByteSize(), "blockgraph byte size");
+  int nulls = 0;
+  for (auto &b : bg.GetBlocks())
+    nulls += b.second == nullptr;
+  // The genesis block is moved to the store too
+  Check(nulls == 1501, "blocks kept in the store");
+  for (auto &b : expected.GetBlocks()){
+    shared_ptr<const Block> read = bg.GetSharedBlock(b.first);
+    Check(Same(read, *b.second), "blockgraph block " + b.first.ToString());
+  }
+  Check(bg.GetChildlessBlocks().size() == 1, "childless blocks from the store");
+  Check(bg.GetBlocksFromGroup(groupId).size() == 1500, "group blocks from the store");
+
+  // Blocks that cannot be read back are reported and skipped, not
+  // dereferenced. The reports are kept out of the test output.
+  truncate((path + ".log").c_str(), 0);
+  stringstream errors;
+  streambuf *out = cout.rdbuf(errors.rdbuf());
+  bool unreadable = bg.GetSharedBlock(expected.GetAllBlockHashes()[1]) == nullptr;
+  size_t childless = bg.GetChildlessBlocks().size();
+  size_t group = bg.GetBlocksFromGroup(groupId).size();
+  string serie = bg.Serialize();
+  bg.ComputeTransactionRepetition();
+  Blockgraph merged;
+  merged.Merge(bg);
+  cout.rdbuf(out);
+
+  Check(unreadable, "unreadable block");
+  Check(childless <= 1, "childless blocks with an unreadable store");
+  Check(group < 1500, "group blocks with an unreadable store");
+  Check(serie.empty(), "no snapshot with an unreadable store");
+  Check(merged.GetBlocksCount() < bg.GetBlocksCount(), "merge skips the unreadable blocks");
+  Check(errors.str().find("ERROR : CANNOT READ BLOCK") != string::npos, "unreadable blocks reported");
+}
+
+int main(int argc, char *argv[]) {
+  string path = "block_store_test." + to_string(getpid());
+
+  TestGrowAndReopen(path);
+  Remove(path);
+  TestGrowFailure(path);
+  Remove(path);
+  TestLru(path);
+  Remove(path);
+  TestBlockgraph(path);
+  Remove(path);
+
+  if (failures > 0){
+    cout << failures << " checks failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
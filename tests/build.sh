@@ -0,0 +1,33 @@
+# Builds the test and benchmark drivers, which do not need ns-3.
+# They are .cpp files so that the ns-3 scratch build, which compiles every
+# .cc file found under scratch/, leaves them out.
+cd "$(dirname "$0")"
+
+CXX=${CXX:-g++}
+CXXFLAGS="-std=c++17 -O2 -Wall -I.."
+mkdir -p bin
+
+$CXX $CXXFLAGS hash_engine_test.cpp ../hash_engine.cc -o bin/hash_engine_test
+$CXX $CXXFLAGS hash_engine_bench.cpp ../hash_engine.cc -o bin/hash_engine_bench
+
+BLOCKGRAPH="../block.cc ../transaction.cc ../block_view.cc ../blockgraph.cc \
+  ../blockgraph_snapshot.cc ../block_store.cc ../header_table.cc ../hash_engine.cc \
+  ../duplicate_tx_detector.cc ../b4m_traces.cc"
+
+$CXX $CXXFLAGS alloc_test.cpp $BLOCKGRAPH -o bin/alloc_test
+$CXX $CXXFLAGS compact_block_bench.cpp ../compact_block.cc $BLOCKGRAPH -o bin/compact_block_bench
+$CXX $CXXFLAGS block_store_test.cpp $BLOCKGRAPH -o bin/block_store_test
+$CXX $CXXFLAGS snapshot_test.cpp ../block_builder.cc $BLOCKGRAPH -o bin/snapshot_test
+$CXX $CXXFLAGS merge_test.cpp ../block_builder.cc $BLOCKGRAPH -o bin/merge_test
+$CXX $CXXFLAGS traversal_test.cpp ../blockgraph_traversal.cc ../block_builder.cc $BLOCKGRAPH -o bin/traversal_test
+$CXX $CXXFLAGS data_transfer_test.cpp ../data_transfer.cc -o bin/data_transfer_test
+
+#./bin/hash_engine_test
+#./bin/hash_engine_bench
+#./bin/alloc_test
+#./bin/compact_block_bench
+#./bin/block_store_test
+#./bin/snapshot_test
+#./bin/merge_test
+#./bin/traversal_test
+#./bin/data_transfer_test
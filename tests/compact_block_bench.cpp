@@ -0,0 +1,124 @@
+/**
+ * Memory per block and traversal time of Block and CompactBlock, for
+ * several numbers of transactions per block.
+ * Heap usage is the growth of the live bytes given by operator new.
+ * Usage: compact_block_bench [blocks per run (default 10000)]
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "block.h"
+#include "compact_block.h"
+#include "transaction.h"
+
+using namespace std;
+
+// Live heap objects and bytes. Each allocation is prefixed by its size.
+static const size_t PREFIX = 16;
+static size_t allocations = 0;
+static size_t allocatedBytes = 0;
+
+void* operator new(size_t size){
+  char *p = (char*) malloc(size + PREFIX);
+  if (p == nullptr)
+    throw bad_alloc();
+  memcpy(p, &size, sizeof(size));
+  allocations++;
+  allocatedBytes += size;
+  return p + PREFIX;
+}
+
+void operator delete(void *p) noexcept{
+  if (p == nullptr)
+    return;
+  char *begin = (char*) p - PREFIX;
+  size_t size;
+  memcpy(&size, begin, sizeof(size));
+  allocations--;
+  allocatedBytes -= size;
+  free(begin);
+}
+
+void operator delete(void *p, size_t size) noexcept{
+  operator delete(p);
+}
+
+static volatile size_t sink;
+
+static Block MakeBlock(int index, int txsCount, int payloadSize){
+  vector<Transaction> transactions;
+  for (int i = 0; i < txsCount; ++i)
+    transactions.push_back(Transaction(to_string(index * 1000 + i), 0,
+                                       string(payloadSize, 'a' + i % 26), index + i * 0.01));
+  vector<string> parents(1, string(Block::HASH_SIZE, (char) index));
+  return Block(to_string(index), index, 0, 0, "1", move(parents), index, move(transactions));
+}
+
+/**
+ * Live heap bytes and objects per element of the vector built by make,
+ * and the time of one read of every transaction with traverse
+ */
+template<typename T, typename Make, typename Traverse>
+static void Measure(const string &name, int blocks, Make make, Traverse traverse){
+  vector<unique_ptr<T>> v;
+  v.reserve(blocks);
+  size_t allocationsBefore = allocations;
+  size_t bytesBefore = allocatedBytes;
+  for (int i = 0; i < blocks; ++i)
+    v.push_back(make(i));
+  double bytes = (double) (allocatedBytes - bytesBefore) / blocks;
+  double count = (double) (allocations - allocationsBefore) / blocks;
+
+  auto start = chrono::steady_clock::now();
+  size_t sum = 0;
+  for (auto &b : v)
+    sum += traverse(*b);
+  sink = sum;
+  double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / blocks;
+
+  cout << "  " << left << setw(14) << name << right << fixed << setprecision(0)
+       << setw(10) << bytes << " bytes" << setw(8) << setprecision(1) << count << " allocs"
+       << setw(10) << ns << " ns/traversal" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int blocks = argc > 1 ? atoi(argv[1]) : 10000;
+  int payloadSize = 64;
+
+  for (int txsCount : {0, 1, 4, 16, 64}){
+    cout << txsCount << " transactions of " << payloadSize << " bytes per block" << endl;
+
+    vector<Block> sources;
+    sources.reserve(blocks);
+    for (int i = 0; i < blocks; ++i)
+      sources.push_back(MakeBlock(i, txsCount, payloadSize));
+
+    Measure<Block>("Block", blocks,
+      [&](int i){ return unique_ptr<Block>(new Block(sources[i])); },
+      [](const Block &b){
+        size_t s = b.GetHash()[0] + b.GetParents().size();
+        for (auto &t : b.GetTransactions())
+          s += t.GetHash()[0] + t.GetPayload()[0] + t.GetSize();
+        return s;
+      });
+
+    Measure<CompactBlock>("CompactBlock", blocks,
+      [&](int i){ return unique_ptr<CompactBlock>(new CompactBlock(sources[i])); },
+      [](const CompactBlock &b){
+        size_t s = b.GetHash().data()[0] + b.GetParentsCount();
+        for (int i = 0; i < b.GetTxsCount(); ++i)
+          s += b.GetTxHash(i).data()[0] + b.GetTxPayload(i)[0] + b.GetTxSize(i);
+        return s;
+      });
+
+    CompactBlock compact(sources[0]);
+    cout << "  CompactBlock::MemoryUsage " << compact.MemoryUsage() << " bytes" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * Tests of TransferSender and TransferReceiver exchanging a dataset over a
+ * simulated link that drops chunks and acknowledgements: the window is
+ * respected, a single loss is resent once, and the dataset is rebuilt
+ * intact whatever the losses.
+ */
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstring>
+
+#include "data_transfer.h"
+#include "utils.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void Check(bool ok, const string &what){
+  if (!ok){
+    cout << "FAIL : " << what << endl;
+    failures++;
+  }
+}
+
+typedef struct exchange_t{
+  int     packets;      // chunk transmissions
+  int     timeouts;
+  int     maxInFlight;  // largest number of chunks on the link at once
+  bool    resentOnLink; // a chunk was resent while a copy was still on the link
+  bool    complete;
+  bool    intact;
+} exchange_t;
+
+/**
+ * Send data in chunks over a FIFO link. drop decides for each chunk
+ * transmission and each acknowledgement if it is lost. The sender times
+ * out when the link is empty and it has nothing new to send.
+ */
+template<typename Drop>
+static exchange_t Exchange(const string &data, int chunkSize, int window, Drop drop){
+  TransferSender sender(data.size(), chunkSize, window);
+  TransferReceiver receiver(data.size(), chunkSize);
+  exchange_t ret = {0, 0, 0, false, false, false};
+  deque<int> link;
+  vector<int> copies(sender.GetChunksCount(), 0);
+
+  int rounds = 0;
+  while (!sender.IsComplete() && rounds++ < 100000){
+    for (int c : sender.NextChunks()){
+      link.push_back(c);
+      if (++copies[c] > 1)
+        ret.resentOnLink = true;
+    }
+    ret.maxInFlight = max(ret.maxInFlight, (int) link.size());
+    if (link.empty()){
+      sender.OnTimeout();
+      ret.timeouts++;
+      continue;
+    }
+
+    int chunk = link.front();
+    link.pop_front();
+    copies[chunk]--;
+    ret.packets++;
+    if (drop(false, chunk))
+      continue;
+    memcpy(receiver.GetChunkData(chunk), data.data() + (size_t) chunk * chunkSize,
+           receiver.GetChunkSize(chunk));
+    receiver.SetReceived(chunk);
+    if (!drop(true, chunk))
+      sender.OnAck(receiver.GetReceivedBitmap());
+  }
+
+  ret.complete = sender.IsComplete() && receiver.IsComplete();
+  ret.intact = string(receiver.GetData().begin(), receiver.GetData().end()) == data;
+  return ret;
+}
+
+static string MakeData(size_t size){
+  mt19937 gen(RANDOM_SEED);
+  string data(size, 0);
+  for (auto &c : data)
+    c = gen();
+  return data;
+}
+
+static void TestNoLoss(){
+  string data = MakeData(40 * 1400);
+  exchange_t e = Exchange(data, 1400, 8, [](bool ack, int chunk){ return false; });
+  Check(e.complete && e.intact, "transfer without loss");
+  Check(e.packets == 40 && e.timeouts == 0, "each chunk sent once");
+  Check(e.maxInFlight <= 8, "window respected");
+}
+
+static void TestSingleLoss(){
+  // The first transmission of chunk 3 is lost: it is detected when a
+  // later chunk is acknowledged and resent once, without a timeout
+  string data = MakeData(40 * 1400);
+  int sends = 0;
+  exchange_t e = Exchange(data, 1400, 32, [&](bool ack, int chunk){
+    return !ack && chunk == 3 && sends++ == 0;
+  });
+  Check(e.complete && e.intact, "transfer with a single loss");
+  Check(e.packets == 41 && sends == 2 && e.timeouts == 0, "single loss resent once");
+}
+
+static void TestShortLastChunk(){
+  string data = MakeData(10 * 1000 + 17);
+  TransferReceiver receiver(data.size(), 1000);
+  Check(receiver.GetChunksCount() == 11 && receiver.GetChunkSize(10) == 17, "size of the last chunk");
+  Check(receiver.SetReceived(4) && !receiver.SetReceived(4), "chunk received twice");
+
+  exchange_t e = Exchange(data, 1000, 4, [](bool ack, int chunk){ return false; });
+  Check(e.complete && e.intact, "transfer with a short last chunk");
+}
+
+static void TestRandomLoss(){
+  mt19937 gen(RANDOM_SEED);
+  string data = MakeData(300 * 1400 + 123);
+  for (double rate : {0.05, 0.2, 0.5}){
+    for (int window : {1, 4, 32}){
+      string at = " loss " + to_string(rate) + " window " + to_string(window);
+      bernoulli_distribution lost(rate);
+
+      // Chunks lost, acknowledgements delivered
+      exchange_t e = Exchange(data, 1400, window, [&](bool ack, int chunk){ return !ack && lost(gen); });
+      Check(e.complete && e.intact, "transfer" + at);
+      Check(e.maxInFlight <= window, "window respected" + at);
+      Check(!e.resentOnLink, "no spurious resend" + at);
+      // Each transmission is lost with probability rate, so a chunk is
+      // sent 1 / (1 - rate) times on average
+      Check(e.packets < 301 / (1 - rate) * 1.2, "transmissions" + at);
+
+      // Chunks and acknowledgements lost. A chunk whose acknowledgement is
+      // lost is sent again after a timeout, possibly while the next window
+      // is on the link, but never while a copy sent before is.
+      e = Exchange(data, 1400, window, [&](bool ack, int chunk){ return lost(gen); });
+      Check(e.complete && e.intact, "transfer with lost acknowledgements" + at);
+      Check(!e.resentOnLink, "no spurious resend with lost acknowledgements" + at);
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  TestNoLoss();
+  TestSingleLoss();
+  TestShortLastChunk();
+  TestRandomLoss();
+
+  if (failures > 0){
+    cout << failures << " checks failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * Throughput of the HashEngine algorithms, on one large buffer and on
+ * transaction-sized inputs.
+ * Usage: hash_engine_bench [buffer size in MB (default 64)]
+ */
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "hash_engine.h"
+
+using namespace std;
+
+static volatile uint32_t sink;
+
+static double Seconds(const function<uint32_t ()> &f){
+  auto start = chrono::steady_clock::now();
+  sink = f();
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static uint32_t Sha256(void (*sha)(const char*, size_t, unsigned char*),
+                       const char *data, size_t length){
+  unsigned char digest[HashEngine::SHA256_SIZE];
+  sha(data, length, digest);
+  return digest[0];
+}
+
+static void Report(const string &name, size_t bytes, int calls,
+                   const function<uint32_t (const char*, size_t)> &hash,
+                   const string &buffer){
+  size_t length = bytes / calls;
+  double s = Seconds([&](){
+    uint32_t r = 0;
+    for (int i = 0; i < calls; ++i)
+      r ^= hash(buffer.data() + (size_t) i * length % (buffer.size() - length), length);
+    return r;
+  });
+  cout << "  " << left << setw(24) << name << right << setw(10) << fixed << setprecision(1)
+       << bytes / s / 1e6 << " MB/s" << setw(12) << setprecision(0) << calls / s << " calls/s" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t megabytes = argc > 1 ? atoi(argv[1]) : 64;
+  size_t bytes = megabytes << 20;
+
+  string buffer(bytes + 4096, 0);
+  mt19937 gen(2);
+  for (auto &c : buffer)
+    c = gen();
+
+  vector<pair<string, function<uint32_t (const char*, size_t)>>> algorithms = {
+    {"CRC32 bytewise", HashEngine::Crc32Bytewise},
+    {"CRC32 slicing-by-8", HashEngine::Crc32},
+    {"CRC32C software", HashEngine::Crc32cSoftware},
+    {HashEngine::HasSse42() ? "CRC32C SSE4.2" : "CRC32C (no SSE4.2)", HashEngine::Crc32c},
+    {"SHA-256 software", [](const char *d, size_t n){ return Sha256(HashEngine::Sha256Software, d, n); }},
+    {HashEngine::HasShaNi() ? "SHA-256 SHA-NI" : "SHA-256 (no SHA-NI)",
+     [](const char *d, size_t n){ return Sha256(HashEngine::Sha256, d, n); }},
+  };
+
+  cout << "Buffer of " << megabytes << " MB" << endl;
+  for (auto &a : algorithms)
+    Report(a.first, bytes, 1, a.second, buffer);
+
+  // Serialized transactions are a few tens of bytes
+  cout << "64 byte inputs" << endl;
+  for (auto &a : algorithms)
+    Report(a.first, bytes / 16, bytes / 16 / 64, a.second, buffer);
+
+  return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * Equivalence tests of HashEngine: standard test vectors, and every
+ * accelerated implementation against its reference on random inputs of
+ * every length and alignment.
+ */
+#include <iostream>
+#include <random>
+#include <string>
+#include <cstring>
+
+#include "hash_engine.h"
+#include "utils.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void Check(bool ok, const string &what){
+  if (!ok){
+    cout << "FAIL : " << what << endl;
+    failures++;
+  }
+}
+
+static string Sha256Hex(const string &data){
+  unsigned char digest[HashEngine::SHA256_SIZE];
+  HashEngine::Sha256(data.data(), data.size(), digest);
+  return dump((const char*) digest, HashEngine::SHA256_SIZE);
+}
+
+static void TestVectors(){
+  Check(HashEngine::Crc32("123456789", 9) == 0xCBF43926, "CRC32 check value");
+  Check(HashEngine::Crc32Bytewise("123456789", 9) == 0xCBF43926, "CRC32 bytewise check value");
+  Check(HashEngine::Crc32c("123456789", 9) == 0xE3069283, "CRC32C check value");
+  Check(HashEngine::Crc32cSoftware("123456789", 9) == 0xE3069283, "CRC32C software check value");
+
+  Check(Sha256Hex("") ==
+        "0xe3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", "SHA-256 empty");
+  Check(Sha256Hex("abc") ==
+        "0xba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", "SHA-256 abc");
+  Check(Sha256Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+        "0x248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", "SHA-256 448 bits");
+  Check(Sha256Hex(string(1000000, 'a')) ==
+        "0xcdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", "SHA-256 million a");
+}
+
+static void TestEquivalence(){
+  mt19937 gen(RANDOM_SEED);
+  string buffer(4096 + 8, 0);
+  for (auto &c : buffer)
+    c = gen();
+
+  // Every length around the 8 byte slices and the 64 byte SHA-256 blocks,
+  // at every alignment
+  for (size_t length = 0; length <= 1024; ++length){
+    for (size_t offset = 0; offset < 8; ++offset){
+      const char *data = buffer.data() + offset;
+      string at = " length " + to_string(length) + " offset " + to_string(offset);
+
+      Check(HashEngine::Crc32(data, length) == HashEngine::Crc32Bytewise(data, length),
+            "CRC32 slicing-by-8" + at);
+      Check(HashEngine::Crc32c(data, length) == HashEngine::Crc32cSoftware(data, length),
+            "CRC32C" + at);
+
+      unsigned char digest[HashEngine::SHA256_SIZE];
+      unsigned char reference[HashEngine::SHA256_SIZE];
+      HashEngine::Sha256(data, length, digest);
+      HashEngine::Sha256Software(data, length, reference);
+      Check(memcmp(digest, reference, sizeof(digest)) == 0, "SHA-256" + at);
+    }
+  }
+}
+
+static void TestHashing(){
+  // hashing() keeps the decimal output of the former bytewise CRC32
+  mt19937 gen(RANDOM_SEED);
+  for (int i = 0; i < 2000; ++i){
+    string data(gen() % 300, 0);
+    for (auto &c : data)
+      c = gen();
+    string expected = to_string(HashEngine::Crc32Bytewise(data.data(), data.size()) >> 8);
+    expected += string(20 - expected.size(), 0);
+    Check(hashing(data, 20) == expected, "hashing() " + to_string(i));
+  }
+}
+
+static void TestDigest(){
+  string data = "b4mesh";
+  uint32_t crc = HashEngine::Crc32c(data.data(), data.size());
+  string digest = HashEngine::Digest(HashEngine::CRC32C, data, 8);
+  Check(memcmp(digest.data(), &crc, sizeof(crc)) == 0 && digest.substr(4) == string(4, 0),
+        "Digest padding");
+
+  unsigned char sha[HashEngine::SHA256_SIZE];
+  HashEngine::Sha256(data.data(), data.size(), sha);
+  Check(HashEngine::Digest(HashEngine::SHA256, data, 20) == string((const char*) sha, 20),
+        "Digest truncation");
+}
+
+int main(int argc, char *argv[]) {
+  cout << "SSE4.2 : " << HashEngine::HasSse42() << " SHA-NI : " << HashEngine::HasShaNi() << endl;
+
+  TestVectors();
+  TestEquivalence();
+  TestHashing();
+  TestDigest();
+
+  if (failures > 0){
+    cout << failures << " checks failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * Tests of Blockgraph::Merge against merging the same blocks one by one
+ * with AddBlock: two groups extend a common history during a partition,
+ * then each side merges the other.
+ */
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+
+#include "block_builder.h"
+#include "blockgraph.h"
+#include "utils.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void Check(bool ok, const string &what){
+  if (!ok){
+    cout << "FAIL : " << what << endl;
+    failures++;
+  }
+}
+
+/**
+ * Extend bg with a chain of count blocks of the group, each with a few
+ * transactions picked among payloads
+ */
+static void Extend(Blockgraph &bg, mt19937 &gen, const string &groupId, int count,
+                   const vector<string> &payloads){
+  for (int i = 0; i < count; ++i){
+    BlockBuilder b;
+    b.SetGroupId(groupId).SetIndex(bg.GetBlocksCount()).SetTimestamp(bg.GetBlocksCount());
+    for (auto &t : bg.GetTips())
+      b.AddParent(t.ToString());
+    for (int t = gen() % 4; t > 0; --t)
+      b.AddTransaction(TransactionBuilder().SetPayload(payloads[gen() % payloads.size()])
+                                           .SetTimestamp(1).Build());
+    bg.AddBlock(b.Build());
+  }
+}
+
+static bool Same(Blockgraph &a, Blockgraph &b){
+  vector<string> x = a.GetAllBlockHashes();
+  vector<string> y = b.GetAllBlockHashes();
+  return x == y && a.GetTips() == b.GetTips() && a.GetByteSize() == b.GetByteSize() &&
+    a.GetTxsCount() == b.GetTxsCount() && a.GetTxsByteSize() == b.GetTxsByteSize() &&
+    a.GetTxsPerBlockHistogram() == b.GetTxsPerBlockHistogram() &&
+    a.GetHeaderTable().GetIndexes() == b.GetHeaderTable().GetIndexes() &&
+    a.GetHeaderTable().GetGroups() == b.GetHeaderTable().GetGroups();
+}
+
+static void TestPartition(int seed){
+  mt19937 gen(RANDOM_SEED + seed);
+  string at = " seed " + to_string(seed);
+
+  vector<string> payloads;
+  for (int i = 0; i < 40; ++i)
+    payloads.push_back("tx" + to_string(seed) + "-" + to_string(i));
+
+  Blockgraph common;
+  Extend(common, gen, "A", 20, payloads);
+
+  // Both groups start from the common history
+  Blockgraph a(common);
+  Blockgraph b(common);
+  Extend(a, gen, "A", 15, payloads);
+  Extend(b, gen, "B", 25, payloads);
+
+  // Transactions of the received blocks already in the receiver
+  set<string> inA;
+  for (auto &h : a.GetAllBlockHashes()){
+    for (auto &t : a.GetSharedBlock(h)->GetTransactions())
+      inA.insert(t.GetHash());
+  }
+  set<string> expected;
+  for (auto &h : b.GetAllBlockHashes()){
+    if (a.HasBlock(h))
+      continue;
+    for (auto &t : b.GetSharedBlock(h)->GetTransactions()){
+      if (inA.count(t.GetHash()))
+        expected.insert(t.GetHash());
+    }
+  }
+
+  // One by one, in the order b received them
+  Blockgraph oneByOne(a);
+  for (auto &h : b.GetAllBlockHashes())
+    oneByOne.AddBlock(b.GetSharedBlock(h));
+
+  Blockgraph merged(a);
+  Blockgraph::merge_t result = merged.Merge(b);
+  Check(Same(merged, oneByOne), "merge equals AddBlock" + at);
+  Check(a.GetBlocksCount() == 36, "copy unchanged by the merge" + at);
+  Check(merged.GetBlocksCount() == 1 + 20 + 15 + 25, "merged blocks count" + at);
+
+  vector<string> tips = merged.GetChildlessBlockList();
+  Check(result.tips == tips && tips.size() == 2, "tips of the merge" + at);
+  Check(set<string> (result.duplicatedTxs.begin(), result.duplicatedTxs.end()) == expected &&
+        result.duplicatedTxs.size() == expected.size(), "duplicated transactions" + at);
+
+  // Blocks are shared, not copied
+  for (auto &h : b.GetAllBlockHashes())
+    Check(merged.GetSharedBlock(h) == b.GetSharedBlock(h) ||
+          merged.GetSharedBlock(h) == a.GetSharedBlock(h), "shared block" + at);
+
+  // Merging again, or merging in the other direction, gives the same DAG
+  Blockgraph again(merged);
+  Blockgraph::merge_t none = again.Merge(b);
+  Check(none.duplicatedTxs.empty() && again.GetBlocksCount() == merged.GetBlocksCount(),
+        "second merge" + at);
+  Blockgraph reverse(b);
+  reverse.Merge(a);
+  vector<string> x = merged.GetAllBlockHashes();
+  vector<string> y = reverse.GetAllBlockHashes();
+  Check(set<string> (x.begin(), x.end()) == set<string> (y.begin(), y.end()) &&
+        reverse.GetTips() == merged.GetTips() && reverse.GetByteSize() == merged.GetByteSize(),
+        "merge in the other direction" + at);
+
+  // The merge block references the tips and joins both branches
+  BlockBuilder m;
+  m.SetGroupId("A").SetIndex(merged.GetBlocksCount()).SetParents(result.tips);
+  merged.AddBlock(m.Build());
+  Check(merged.GetTips().size() == 1, "single tip after the merge block" + at);
+  Check(merged.GetDuplicateTxDetector().GetJoinsCount() == 1, "merge block joins the branches" + at);
+}
+
+static void TestSelf(){
+  Blockgraph bg;
+  mt19937 gen(RANDOM_SEED);
+  Extend(bg, gen, "A", 10, vector<string> (1, "tx"));
+  Blockgraph copy(bg);
+  Blockgraph::merge_t result = bg.Merge(copy);
+  Check(bg.GetBlocksCount() == 11 && result.duplicatedTxs.empty() &&
+        result.tips == bg.GetChildlessBlockList(), "merge of a copy");
+}
+
+int main(int argc, char *argv[]) {
+  for (int seed = 0; seed < 10; ++seed)
+    TestPartition(seed);
+  TestSelf();
+
+  if (failures > 0){
+    cout << failures << " checks failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * Tests of the blockgraph snapshots: a blockgraph rebuilt from its snapshot
+ * equals the original and leaves its blocks in the snapshot, and truncated
+ * or corrupted snapshots are rejected without reading out of their buffer.
+ */
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <unistd.h>
+
+#include "block_builder.h"
+#include "blockgraph.h"
+#include "blockgraph_snapshot.h"
+#include "utils.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void Check(bool ok, const string &what){
+  if (!ok){
+    cout << "FAIL : " << what << endl;
+    failures++;
+  }
+}
+
+static string Serialize(const Block &b){
+  string serie(b.SerializedSize(), 0);
+  b.SerializeTo(&serie[0]);
+  return serie;
+}
+
+/**
+ * A random DAG of blocks in two groups, each with a few transactions
+ */
+static Blockgraph MakeBlockgraph(int count){
+  mt19937 gen(RANDOM_SEED);
+  Blockgraph bg;
+  vector<string> hashes = bg.GetAllBlockHashes();
+  for (int i = 1; i <= count; ++i){
+    BlockBuilder b;
+    b.SetIndex(i).SetLeader(gen() % 4).SetGroupId(to_string(gen() % 2)).SetTimestamp(i * 0.5);
+    int lowest = max(0, (int) hashes.size() - 6);
+    b.AddParent(hashes[lowest + gen() % (hashes.size() - lowest)]);
+    if (gen() % 4 == 0)
+      b.AddParent(hashes[lowest + gen() % (hashes.size() - lowest)]);
+    for (int t = gen() % 5; t > 0; --t)
+      b.AddTransaction(TransactionBuilder().SetPayload(string(10 + gen() % 50, 'a' + t))
+                                           .SetTimestamp(i + t * 0.01).Build());
+    shared_ptr<const Block> block = b.Build();
+    bg.AddBlock(block);
+    hashes.push_back(block->GetHash());
+  }
+  return bg;
+}
+
+static bool Same(const Blockgraph &a, const Blockgraph &b){
+  if (a.GetBlocksCount() != b.GetBlocksCount() || a.GetTips() != b.GetTips())
+    return false;
+  if (a.GetAllBlockHashes() != b.GetAllBlockHashes())
+    return false;
+  for (auto &h : a.GetAllBlockHashes()){
+    shared_ptr<const Block> x = a.GetSharedBlock(h);
+    shared_ptr<const Block> y = b.GetSharedBlock(h);
+    if (x == nullptr || y == nullptr || Serialize(*x) != Serialize(*y))
+      return false;
+  }
+  const HeaderTable &x = a.GetHeaderTable();
+  const HeaderTable &y = b.GetHeaderTable();
+  return x.GetIndexes() == y.GetIndexes() && x.GetSizes() == y.GetSizes() &&
+    x.GetTxsCounts() == y.GetTxsCounts() && x.GetGroups() == y.GetGroups() &&
+    x.GetTimestamps() == y.GetTimestamps();
+}
+
+static void TestRoundTrip(const Blockgraph &bg){
+  string serie = bg.Serialize();
+  Check(BlockgraphSnapshot::GetSize(serie.data()) == serie.size(), "snapshot size");
+
+  Blockgraph loaded(serie.data(), serie.size());
+  Check(Same(bg, loaded), "round trip");
+  Blockgraph fromHeader(&serie[0]);
+  Check(Same(bg, fromHeader), "round trip with the length from the header");
+
+  Blockgraph copy(bg);
+  Check(Same(bg, copy) && copy.Serialize() == serie, "snapshot of a copy");
+  Check(loaded.Serialize() == serie, "snapshot of a loaded blockgraph");
+
+  // Blocks stay in the snapshot, only the genesis block of the empty
+  // blockgraph is in memory
+  int nulls = 0;
+  for (auto &b : loaded.GetBlocks())
+    nulls += b.second == nullptr;
+  Check(nulls == loaded.GetBlocksCount() - 1, "blocks left in the snapshot");
+
+  // A file is mapped rather than copied
+  string path = "snapshot_test." + to_string(getpid());
+  Check(BlockgraphSnapshot::Save(bg, path), "save snapshot");
+  shared_ptr<BlockgraphSnapshot> file = make_shared<BlockgraphSnapshot>();
+  Check(file->Open(path), "open snapshot");
+  unlink(path.c_str());
+  Blockgraph mapped(file);
+  Check(Same(bg, mapped), "round trip through a file");
+
+  // Blocks added after the load are kept in memory
+  Blockgraph grown(loaded);
+  shared_ptr<const Block> block = BlockBuilder().SetIndex(1000).AddParent(bg.GetTips().begin()->ToString()).Build();
+  grown.AddBlock(block);
+  Check(grown.GetSharedBlock(block->GetHash()) == block && grown.GetBlocksCount() == bg.GetBlocksCount() + 1,
+        "block added to a loaded blockgraph");
+  Check(Same(bg, loaded), "loaded blockgraph unchanged by its copy");
+
+  Blockgraph empty;
+  string emptySerie = empty.Serialize();
+  Check(Same(empty, Blockgraph(emptySerie.data(), emptySerie.size())), "round trip of the genesis block");
+}
+
+/**
+ * The blockgraph loaded from a corrupted snapshot, with the error reports
+ * kept out of the test output
+ */
+static Blockgraph Load(const string &serie, size_t length){
+  stringstream errors;
+  streambuf *out = cout.rdbuf(errors.rdbuf());
+  Blockgraph bg(serie.data(), length);
+  for (auto &h : bg.GetAllBlockHashes())
+    bg.GetSharedBlock(h);
+  cout.rdbuf(out);
+  return bg;
+}
+
+static void TestCorrupted(const Blockgraph &bg){
+  string serie = bg.Serialize();
+  BlockgraphSnapshot::snapshot_hdr_t hdr;
+  memcpy(&hdr, serie.data(), sizeof(hdr));
+
+  string magic = serie;
+  magic[0] = 'X';
+  Check(BlockgraphSnapshot::GetSize(magic.data()) == 0, "size of a bad magic");
+  Check(Load(magic, magic.size()).GetBlocksCount() == 1, "bad magic");
+
+  string version = serie;
+  ((BlockgraphSnapshot::snapshot_hdr_t*) &version[0])->version++;
+  Check(BlockgraphSnapshot::GetSize(version.data()) == 0, "size of a bad version");
+  Check(Load(version, version.size()).GetBlocksCount() == 1, "bad version");
+
+  for (size_t length : {(size_t) 0, sizeof(hdr) - 1, sizeof(hdr), (size_t) hdr.payload_offset,
+                        serie.size() - 1})
+    Check(Load(serie, length).GetBlocksCount() == 1, "truncated to " + to_string(length));
+
+  string count = serie;
+  ((BlockgraphSnapshot::snapshot_hdr_t*) &count[0])->block_count = 0x7fffffff;
+  Check(Load(count, count.size()).GetBlocksCount() == 1, "block count past the table");
+
+  string offset = serie;
+  ((BlockgraphSnapshot::snapshot_hdr_t*) &offset[0])->payload_offset = ~(uint64_t) 0;
+  Check(Load(offset, offset.size()).GetBlocksCount() == 1, "payload offset past the end");
+
+  // A block lying outside of the payloads is left out, the others are kept
+  string entry = serie;
+  BlockgraphSnapshot::snapshot_block_t *table =
+    (BlockgraphSnapshot::snapshot_block_t*) &entry[hdr.table_offset];
+  table[5].offset = ~(uint64_t) 0 - 2;
+  Check(Load(entry, entry.size()).GetBlocksCount() == bg.GetBlocksCount() - 1,
+        "block outside of the payloads");
+
+  // Random bytes anywhere in the snapshot must not make the load read out
+  // of the buffer
+  mt19937 gen(RANDOM_SEED);
+  for (int i = 0; i < 300; ++i){
+    string corrupted = serie;
+    for (int j = 0; j < 8; ++j)
+      corrupted[gen() % corrupted.size()] = gen();
+    Blockgraph loaded = Load(corrupted, corrupted.size());
+    Check(loaded.GetBlocksCount() <= bg.GetBlocksCount(), "random corruption " + to_string(i));
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Blockgraph bg = MakeBlockgraph(300);
+
+  TestRoundTrip(bg);
+  TestCorrupted(bg);
+
+  if (failures > 0){
+    cout << failures << " checks failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
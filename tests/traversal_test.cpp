@@ -0,0 +1,210 @@
+/**
+ * Tests of BlockgraphTraversal against brute force searches on random
+ * DAGs received out of order: ancestry, ancestors and descendants, lowest
+ * common ancestors and topological order. Also checks that repeated forks
+ * and merges do not add chains.
+ */
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+
+#include "block_builder.h"
+#include "blockgraph.h"
+#include "blockgraph_traversal.h"
+#include "utils.h"
+
+using namespace std;
+
+static int failures = 0;
+
+static void Check(bool ok, const string &what){
+  if (!ok){
+    cout << "FAIL : " << what << endl;
+    failures++;
+  }
+}
+
+/**
+ * Random DAG: each block has one to three parents among the last blocks
+ */
+static vector<shared_ptr<const Block>> MakeDag(mt19937 &gen, const string &genesis, int count){
+  vector<shared_ptr<const Block>> blocks;
+  vector<string> hashes(1, genesis);
+  for (int i = 1; i <= count; ++i){
+    BlockBuilder b;
+    b.SetIndex(i).SetTimestamp(i);
+    int lowest = max(0, (int) hashes.size() - 10);
+    set<int> parents;
+    for (int p = 1 + gen() % 3; p > 0; --p)
+      parents.insert(lowest + gen() % (hashes.size() - lowest));
+    for (int p : parents)
+      b.AddParent(hashes[p]);
+    blocks.push_back(b.Build());
+    hashes.push_back(blocks.back()->GetHash());
+  }
+  return blocks;
+}
+
+/**
+ * Strict ancestors of every block, by a search over the parents
+ */
+static map<string, set<string>> Ancestors(const string &genesis, const vector<shared_ptr<const Block>> &blocks){
+  map<string, set<string>> ret;
+  ret[genesis] = set<string> ();
+  // Blocks are generated parents first
+  for (auto &b : blocks){
+    set<string> &a = ret[b->GetHash()];
+    for (auto &p : b->GetParents()){
+      a.insert(p);
+      a.insert(ret[p].begin(), ret[p].end());
+    }
+  }
+  return ret;
+}
+
+static bool InOrder(const BlockgraphTraversal &tr, const vector<string> &hashes){
+  const vector<int> &order = tr.GetTopologicalOrder();
+  vector<int> position(tr.GetBlocksCount(), -1);
+  for (size_t i = 0; i < order.size(); ++i)
+    position[order[i]] = i;
+  for (size_t i = 1; i < hashes.size(); ++i){
+    if (position[tr.GetOrdinal(hashes[i - 1])] >= position[tr.GetOrdinal(hashes[i])])
+      return false;
+  }
+  return true;
+}
+
+static void TestRandomDag(int seed){
+  mt19937 gen(RANDOM_SEED + seed);
+  Blockgraph bg;
+  string genesis = bg.GetAllBlockHashes()[0];
+  vector<shared_ptr<const Block>> blocks = MakeDag(gen, genesis, 250);
+  map<string, set<string>> ancestors = Ancestors(genesis, blocks);
+  string at = " seed " + to_string(seed);
+
+  // Out of order arrival, with updates in between
+  vector<shared_ptr<const Block>> arrival = blocks;
+  for (size_t i = 0; i + 4 < arrival.size(); i += 4)
+    shuffle(arrival.begin() + i, arrival.begin() + i + 4, gen);
+  BlockgraphTraversal tr(bg);
+  for (size_t i = 0; i < arrival.size(); ++i){
+    bg.AddBlock(arrival[i]);
+    if (gen() % 10 == 0)
+      tr.Update();
+  }
+  tr.Update();
+
+  Check(tr.GetTopologicalOrder().size() == (size_t) bg.GetBlocksCount(), "every block linearized" + at);
+  for (auto &b : blocks){
+    for (auto &p : b->GetParents())
+      Check(InOrder(tr, {p, b->GetHash()}), "parent before child" + at);
+  }
+
+  vector<string> hashes = bg.GetAllBlockHashes();
+  for (auto &a : hashes){
+    for (auto &b : hashes){
+      if (tr.IsAncestor(a, b) != (ancestors[b].count(a) > 0))
+        Check(false, "IsAncestor" + at);
+    }
+  }
+
+  map<string, set<string>> descendants;
+  for (auto &b : ancestors){
+    for (auto &a : b.second)
+      descendants[a].insert(b.first);
+  }
+  for (auto &h : hashes){
+    vector<string> a = tr.GetAncestors(h);
+    Check(set<string> (a.begin(), a.end()) == ancestors[h] && a.size() == ancestors[h].size() &&
+          InOrder(tr, a), "GetAncestors" + at);
+    vector<string> d = tr.GetDescendants(h);
+    Check(set<string> (d.begin(), d.end()) == descendants[h] && d.size() == descendants[h].size() &&
+          InOrder(tr, d), "GetDescendants" + at);
+  }
+
+  for (int i = 0; i < 200; ++i){
+    vector<string> query;
+    for (int n = 1 + gen() % 4; n > 0; --n)
+      query.push_back(hashes[gen() % hashes.size()]);
+
+    // Common ancestors or selves, without those having a descendant with
+    // the same property
+    set<string> common;
+    for (auto &h : hashes){
+      bool all = true;
+      for (auto &q : query)
+        all = all && (h == q || ancestors[q].count(h) > 0);
+      if (all)
+        common.insert(h);
+    }
+    set<string> lowest;
+    for (auto &c : common){
+      bool low = true;
+      for (auto &o : common)
+        low = low && !(o != c && ancestors[o].count(c) > 0);
+      if (low)
+        lowest.insert(c);
+    }
+    vector<string> lca = tr.GetLowestCommonAncestors(query);
+    Check(set<string> (lca.begin(), lca.end()) == lowest && lca.size() == lowest.size(),
+          "GetLowestCommonAncestors" + at);
+  }
+}
+
+static void TestMissingParent(){
+  Blockgraph bg;
+  string genesis = bg.GetAllBlockHashes()[0];
+  shared_ptr<const Block> a = BlockBuilder().SetIndex(1).AddParent(genesis).Build();
+  shared_ptr<const Block> b = BlockBuilder().SetIndex(2).AddParent(a->GetHash()).Build();
+  BlockgraphTraversal tr(bg);
+  bg.AddBlock(b);
+  tr.Update();
+  Check(!tr.IsLinearized(tr.GetOrdinal(b->GetHash())), "block waiting for its parent");
+  Check(!tr.IsAncestor(genesis, b->GetHash()), "waiting block ignored by the queries");
+  bg.AddBlock(a);
+  tr.Update();
+  Check(tr.IsLinearized(tr.GetOrdinal(b->GetHash())) && tr.IsAncestor(genesis, b->GetHash()),
+        "block linearized once its parent arrives");
+}
+
+static void TestForksAndMerges(){
+  Blockgraph bg;
+  BlockgraphTraversal tr(bg);
+  string genesis = bg.GetAllBlockHashes()[0];
+  string tip = genesis;
+  for (int i = 0; i < 1000; ++i){
+    shared_ptr<const Block> x = BlockBuilder().SetIndex(3 * i + 1).SetLeader(1).AddParent(tip).Build();
+    shared_ptr<const Block> y = BlockBuilder().SetIndex(3 * i + 1).SetLeader(2).AddParent(tip).Build();
+    shared_ptr<const Block> m = BlockBuilder().SetIndex(3 * i + 2).AddParent(x->GetHash())
+                                              .AddParent(y->GetHash()).Build();
+    bg.AddBlock(x);
+    bg.AddBlock(y);
+    bg.AddBlock(m);
+    tip = m->GetHash();
+    if (i % 100 == 0)
+      tr.Update();
+  }
+  tr.Update();
+  Check(tr.GetChainsCount() <= 2, "chains of repeated forks and merges");
+  Check(tr.IsAncestor(genesis, tip), "genesis ancestor of the last merge");
+  Check(tr.GetLowestCommonAncestors(vector<string> (1, tip)) == vector<string> (1, tip),
+        "lowest common ancestor of a single block");
+}
+
+int main(int argc, char *argv[]) {
+  for (int seed = 0; seed < 5; ++seed)
+    TestRandomDag(seed);
+  TestMissingParent();
+  TestForksAndMerges();
+
+  if (failures > 0){
+    cout << failures << " checks failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
@@ -12,22 +12,15 @@ Transaction::Transaction(){
 
 Transaction::Transaction (string hash, int size,
                           string payload, double timestamp){
-  this->hash =         hash;
+  this->hash =         move(hash);
   this->size =         size;
-  this->payload =      payload;
+  this->payload =      move(payload);
   this->timestamp = timestamp;
 
   CalculateSize();
   CalculateHash();
 }
 
-Transaction::Transaction (const Transaction &tx){
-  hash =         tx.hash;
-  size =         tx.size;
-  payload =      tx.payload;
-  timestamp = tx.timestamp;
-}
-
 Transaction::Transaction(const string &serie){
   const char *p = serie.data();
   transaction_t* p_header = (transaction_t*)p;
@@ -39,21 +32,24 @@ Transaction::Transaction(const string &serie){
   payload = string(p+sizeof(transaction_t), payload_size);
 
 }
-Transaction::~Transaction (){
 
+Transaction::Transaction(const tx_t &header, string payload){
+  hash = string(header.hash, HASH_SIZE);
+  size = header.size;
+  timestamp = header.timestamp;
+  this->payload = move(payload);
 }
 
-string Transaction::GetHash (){
+const string& Transaction::GetHash () const{
   return hash;
 }
 
 void Transaction::SetHash(string hash){
-  this->hash = hash;
+  this->hash = move(hash);
 }
 
-int Transaction::GetSize (){
-  CalculateSize();
-  return size;
+int Transaction::GetSize () const{
+  return CalculateHeaderSize() + payload.size();
 }
 
 void Transaction::SetSize (int size){
@@ -61,17 +57,17 @@ void Transaction::SetSize (int size){
   CalculateHash();
 }
 
-string Transaction::GetPayload (){
+const string& Transaction::GetPayload () const{
   return payload;
 }
 
 void Transaction::SetPayload (string payload){
-  this->payload = payload;
+  this->payload = move(payload);
   CalculateSize();
   CalculateHash();
 }
 
-double Transaction::GetTimestamp (){
+double Transaction::GetTimestamp () const{
   return timestamp;
 }
 
@@ -80,27 +76,37 @@ void Transaction::SetTimestamp (double timestamp){
   CalculateHash();
 }
 
-Transaction& Transaction::operator=(const Transaction &tx2){
-  hash = tx2.hash;
-  size = tx2.size;
-  payload = tx2.payload;
-  timestamp = tx2.timestamp;
+string Transaction::Serialize(){
+  string ret(SerializedSize(), 0);
+  SerializeTo(&ret[0]);
+  return ret;
+}
 
-  return *this;
+size_t Transaction::SerializedSize() const{
+  return sizeof(transaction_t) + payload.size();
 }
 
-string Transaction::Serialize(){
-  string ret = "";
+char* Transaction::SerializeTo(char *buffer) const{
+  buffer = SerializeHeader(buffer);
+  memcpy(buffer, payload.data(), payload.size());
+  return buffer + payload.size();
+}
+
+void Transaction::SerializeIov(char *header, vector<iovec> &iov) const{
+  SerializeHeader(header);
+  iov.push_back({header, sizeof(transaction_t)});
+  if (!payload.empty())
+    iov.push_back({(void*) payload.data(), payload.size()});
+}
+
+char* Transaction::SerializeHeader(char *buffer) const{
   transaction_t header;
 
   header.timestamp = timestamp;
   header.size = size;
   memcpy(header.hash, hash.data(), HASH_SIZE);
-  ret = ret + string((char*)&header, sizeof(header));
-
-  ret = ret + payload;
-  return ret;
-
+  memcpy(buffer, &header, sizeof(header));
+  return buffer + sizeof(header);
 }
 
 bool Transaction::operator== (const Transaction &tx){
@@ -117,7 +123,7 @@ int Transaction::CalculateSize(){
   size = CalculateHeaderSize() + payload.size();
   return size;
 }
-int Transaction::CalculateHeaderSize(){
+int Transaction::CalculateHeaderSize() const{
   return HASH_SIZE + sizeof(size) + sizeof(timestamp);
 }
 
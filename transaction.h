@@ -5,8 +5,10 @@
 #include <string>
 #include <vector>
 #include <string.h>
+#include <sys/uio.h>
 
 #include "utils.h"
+#include "fixed_hash.h"
 
 using namespace std;
 
@@ -26,38 +28,63 @@ class Transaction{
     //constructor and destructor
     Transaction();
     Transaction (string hash, int size, string payload, double timestamp);
-    Transaction (const Transaction &tx);
+    Transaction (const Transaction &tx) = default;
+    Transaction (Transaction &&tx) = default;
     Transaction (const string& serie);
-    ~Transaction();
+    /**
+     * Build a transaction from its serialized header and its payload.
+     * The hash and size are taken as is, not calculated.
+     */
+    Transaction (const tx_t &header, string payload);
+    ~Transaction() = default;
 
   public:
     //Getters, Setters & Operators
-    string GetHash (void);
+    const string& GetHash (void) const;
     void SetHash (string hash);
 
-    int GetSize (void);
+    int GetSize (void) const;
     void SetSize (int size);
 
-    string GetPayload (void);
+    const string& GetPayload (void) const;
     void SetPayload (string payload);
 
-    double GetTimestamp (void);
+    double GetTimestamp (void) const;
     void SetTimestamp (double timestamp);
 
 
     bool operator==(const Transaction &tx);
     friend std::ostream& operator<< (std::ostream &out, const Transaction &tx);
-    Transaction& operator=(const Transaction &tx2);
+    Transaction& operator=(const Transaction &tx2) = default;
+    Transaction& operator=(Transaction &&tx2) = default;
 
   public:
     string Serialize();
+    /**
+     * Return the number of bytes written by SerializeTo
+     */
+    size_t SerializedSize() const;
+    /**
+     * Write the serialized transaction to buffer, which must hold
+     * SerializedSize() bytes. Return the end of the written bytes.
+     */
+    char* SerializeTo(char *buffer) const;
+    /**
+     * Write the transaction header to header and append to iov two entries
+     * referencing header and the payload, which is not copied.
+     * header must hold sizeof(tx_t) bytes.
+     */
+    void SerializeIov(char *header, vector<iovec> &iov) const;
     int CalculateSize();
-    int CalculateHeaderSize();
+    int CalculateHeaderSize() const;
     string CalculateHash();
 
   public:
     // Other functions
 
+  private:
+    char* SerializeHeader(char *buffer) const;
+
   private:
 
     string    hash;           // Identifier of a Tx
@@ -66,4 +93,6 @@ class Transaction{
     string    payload;        // data of the transaction
 };
 
+typedef FixedHash<Transaction::HASH_SIZE> TxHash;
+
 #endif